@@ -1,12 +1,14 @@
 // Copyright (c) 2025 wibyuan
 // Licensed under the MIT License (see LICENSE for details)
 #include "AlphaBetaAI.h" // 头文件
-#include <numeric>        // 用于 std::iota
+#include "PatternKernel.h" // 批量落子增益
 #include <algorithm>      // 用于 std::sort, std::max, std::min, std::fill
 #include <limits>         // 用于 std::numeric_limits
 #include <cmath>          // 用于 std::abs
 #include <iostream>       // 用于调试输出
 #include <vector>
+#include <thread>         // 用于 Lazy SMP 辅助线程
+#include <utility>        // 用于 std::move
 
 // 辅助函数，用于在必要时映射棋子值
 // 假设 Constants.h 中的 EMPTY_PIECE=0, BLACK_PIECE=1, WHITE_PIECE=2 在数值上对应 0,1,2
@@ -23,87 +25,390 @@ inline int map_to_internal_b_piece(int external_piece_from_board_or_player) {
 }
 
 
-AlphaBetaAI::AlphaBetaAI(int searchDepthU_default, int branchFactorV_default) :
+// SplitMix64 伪随机数，用固定种子生成 Zobrist 键，保证每次运行得到的哈希值一致
+static std::uint64_t splitmix64_next(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+// 9 格窗口编码 -> 线段分数的紧凑表。窗口中的墙就是被棋盘边界截掉的部分，
+// 只统计完全落在墙内的 5 格窗口: 没有对方棋子时按己方子数计分。
+// 函数内静态对象只构建一次 (C++11 起线程安全)，之后所有引擎实例都只取指针
+struct WindowScoreTable {
+    std::array<ABAIWindowScores, ABAI_WINDOW_CODES> scores{};
+
+    WindowScoreTable() {
+        // 中心格总在棋盘内，墙只会出现在窗口两端，且每端最多 4 格；其余编码不会出现，保持为 0
+        std::array<int, ABAI_LINE_WINDOW> cells;
+        for (int left = 0; left <= 4; ++left) {
+            for (int right = 0; right <= 4; ++right) {
+                const int inner = ABAI_LINE_WINDOW - left - right;
+                int state_count = 1;
+                for (int i = 0; i < inner; ++i) state_count *= 3;
+                for (int state = 0; state < state_count; ++state) {
+                    std::uint32_t code = 0;
+                    int rest = state;
+                    for (int i = 0; i < ABAI_LINE_WINDOW; ++i) {
+                        if (i < left || i >= left + inner) {
+                            cells[i] = 3;
+                        } else {
+                            cells[i] = rest % 3;
+                            rest /= 3;
+                        }
+                        code |= static_cast<std::uint32_t>(cells[i]) << (2 * i);
+                    }
+                    scores[code] = scoreCells(cells);
+                }
+            }
+        }
+    }
+
+    static ABAIWindowScores scoreCells(const std::array<int, ABAI_LINE_WINDOW>& cells) {
+        ABAIWindowScores result = {0, 0};
+        for (int start = 0; start + 5 <= ABAI_LINE_WINDOW; ++start) {
+            int count[4] = {0, 0, 0, 0};
+            for (int k = start; k < start + 5; ++k) ++count[cells[k]];
+            if (count[3] > 0) continue; // 窗口越过了棋盘边界
+            if (count[2] == 0) result.black += count[1] == 5 ? 0x100 : ABAI_SHAPE_SCORES[count[1]];
+            if (count[1] == 0) result.white += count[2] == 5 ? 0x100 : ABAI_SHAPE_SCORES[count[2]];
+        }
+        return result;
+    }
+};
+
+static const std::array<ABAIWindowScores, ABAI_WINDOW_CODES>& windowScoreTable() {
+    static const WindowScoreTable table;
+    return table.scores;
+}
+
+
+AlphaBetaAI::AlphaBetaAI(int searchDepthU_default, int branchFactorV_default, int ttSizeMB_default) :
+    AlphaBetaAI(searchDepthU_default, branchFactorV_default,
+                std::make_shared<TranspositionTable>(static_cast<std::size_t>(ttSizeMB_default > 0 ? ttSizeMB_default : 1)))
+{
+}
+
+AlphaBetaAI::AlphaBetaAI(int searchDepthU_default, int branchFactorV_default, std::shared_ptr<TranspositionTable> shared_tt) :
     aiPlayerColor_op(EMPTY_PIECE), // 将在 getMove 中设置 (0:空, 1:黑, 2:白)
+    window_values_wv(windowScoreTable().data()),
+    evaluator_ev(ABAIEvaluator::SHAPE_WINDOWS),
+    pattern_classes_pc(nullptr),
     current_white_total_score(0),
     current_black_total_score(0),
     best_r_from_dfs(-1),
     best_c_from_dfs(-1),
+    current_hash_key_zh(0),
+    candidate_count_cc(0),
+    transposition_table_tt(std::move(shared_tt)),
+    tt_probe_count(0),
+    tt_hit_count(0),
+    tt_cutoff_count(0),
     current_search_depth_U(searchDepthU_default), // 已初始化，但 getMove 将进行设置
     current_branch_factor_V(branchFactorV_default),// 已初始化，但 getMove 将进行设置
     default_search_depth_U(searchDepthU_default),
-    default_branch_factor_V(branchFactorV_default)
+    default_branch_factor_V(branchFactorV_default),
+    search_time_limit_ms(ABAI_DEFAULT_TIME_LIMIT_MS),
+    search_node_limit(0),
+    nodes_searched_ns(0),
+    search_aborted_sa(false),
+    completed_search_depth(0),
+    previous_pv_length(0),
+    multi_pv_count_mp(1),
+    root_exclusion_active_re(false),
+    completed_line_count_lc(0),
+    follow_pv_flag(false),
+    cutoff_node_count(0),
+    first_move_cutoff_count(0),
+    pvs_enabled_pe(true),
+    aspiration_window_aw(ABAI_ASPIRATION_WINDOW),
+    pvs_research_count(0),
+    aspiration_research_count(0),
+    quiescence_enabled_qs(true),
+    quiescence_node_count(0),
+    lmr_enabled_lr(true),
+    null_move_enabled_nm(true),
+    lmr_reduction_count(0),
+    lmr_research_count(0),
+    null_move_try_count(0),
+    null_move_cutoff_count(0),
+    null_move_verified_count(0),
+    helper_stop_flag(false),
+    shared_stop_sp(nullptr),
+    threat_nodes_tn(0),
+    threat_node_limit_tl(ABAI_THREAT_NODE_LIMIT),
+    threat_deadline_active_td(false),
+    threat_solver_enabled_ts(true),
+    root_move_filter_active_rf(false),
+    state_synced_ss(false),
+    synced_stone_count_sc(0),
+    ponder_enabled_pd(true),
+    ponder_stop_flag(false),
+    ponder_done_pd(false),
+    ponder_color_pc(EMPTY_PIECE),
+    ponder_reply_pr(-1),
+    ponder_hit_count(0),
+    ponder_miss_count(0),
+    trace_entry_flags_tf(0),
+    trace_reason_tr(SearchTraceReason::EXACT),
+    trace_cut_index_tc(0),
+    trace_node_flags_tn(0)
     // 数组成员会被默认初始化或在下方的方法中初始化
 {
     std::cout << "[调试] 正在初始化 AlphaBetaAI (头文件V2)..." << std::endl;
 
-    // 初始化 p3_powers_p3
-    p3_powers_p3[0] = 1;
-    for (int i = 1; i < ABAI_P3_POWERS_SIZE; ++i) {
-        p3_powers_p3[i] = p3_powers_p3[i - 1] * 3;
+    initializeZobristKeys();
+    near_stone_count_nc.fill(0);
+    candidate_pos_cp.fill(-1);
+    for (auto& cell_gains : cell_line_gain_lg) for (auto& gains : cell_gains) gains.fill(0);
+    for (auto& gains : cell_gain_cg) gains.fill(0);
+    root_move_allowed_rm.fill(false);
+    root_move_excluded_me.fill(false);
+    threat_line_length_tk.fill(0);
+    threat_result_tr.winning_line.reserve(ABAI_THREAT_MAX_PLY);
+    threat_result_tr.defence_moves.reserve(ABAI_N * ABAI_N);
+    for (auto& killers : killer_moves_km) killers.fill(-1);
+    for (auto& side_history : history_table_ht) side_history.fill(0);
+    depth_time_ms_dt.fill(-1);
+    depth_nodes_dn.fill(0);
+    trace_path_tp.fill(STRACE_NO_MOVE);
+#if ABAI_SEARCH_STATS
+    cutoff_index_count_ci.fill(0);
+    evaluation_update_count_eu = 0;
+#endif
+}
+
+AlphaBetaAI::~AlphaBetaAI() {
+    stopPondering(); // 后台线程引用本实例的成员，必须先结束
+}
+
+void AlphaBetaAI::initializeZobristKeys() {
+    std::uint64_t seed = 0x5769627975616EULL; // 固定种子
+    for (auto& cell_keys : zobrist_keys_zb) {
+        cell_keys[0] = 0; // 空位不参与哈希
+        cell_keys[1] = splitmix64_next(seed);
+        cell_keys[2] = splitmix64_next(seed);
     }
+    zobrist_side_keys_zs[0] = 0;
+    zobrist_side_keys_zs[1] = splitmix64_next(seed);
+    zobrist_side_keys_zs[2] = splitmix64_next(seed);
+    zobrist_ai_color_keys_za[0] = 0;
+    zobrist_ai_color_keys_za[1] = splitmix64_next(seed);
+    zobrist_ai_color_keys_za[2] = splitmix64_next(seed);
+    zobrist_evaluator_keys_ze[0] = 0; // 窗口计分的键与加入评估选项之前相同
+    zobrist_evaluator_keys_ze[1] = splitmix64_next(seed);
+}
+
+void AlphaBetaAI::setTranspositionTableSize(int size_mb) {
+    stopPondering(); // 后台搜索共享这张表，必须先结束才能释放
+    transposition_table_tt->resize(static_cast<std::size_t>(size_mb > 0 ? size_mb : 1));
+}
 
-    // 初始化 shape_scores_v 
-    shape_scores_v[0] = 0;
-    shape_scores_v[1] = 1;
-    for (int i = 2; i < 5; ++i) { // 直到 v[4]
-        shape_scores_v[i] = shape_scores_v[i - 1] * 3;
+// 持久置换表的格式标记: 表中的键来自 Zobrist 键，分数来自窗口分数表与棋型分数表，任一改变后旧文件都不可信
+std::uint64_t AlphaBetaAI::persistentTableTag() const {
+    std::uint64_t tag = zobrist_keys_zb[0][1] ^ zobrist_side_keys_zs[1] ^ zobrist_ai_color_keys_za[1];
+    for (int score : ABAI_SHAPE_SCORES) {
+        tag ^= static_cast<std::uint64_t>(score);
+        tag = splitmix64_next(tag);
     }
-    if (5 < ABAI_V_WEIGHTS_SIZE) { // 确保 v[5] 在边界内
-        shape_scores_v[5] = 10000000; // 1e7 代表五子连珠
+    for (int score : ABAI_PATTERN_SCORES) {
+        tag ^= static_cast<std::uint64_t>(score);
+        tag = splitmix64_next(tag);
     }
+    return tag;
+}
 
+bool AlphaBetaAI::openPersistentTranspositionTable(const std::string& path, int size_mb) {
+    stopPondering(); // openFile 会解除原来的映射，后台搜索必须先结束
+    return transposition_table_tt->openFile(path, static_cast<std::size_t>(size_mb > 0 ? size_mb : 1), persistentTableTag());
+}
 
-    // 初始化 fnd_cx_temp 
-    fnd_cx_temp.fill(0);
+bool AlphaBetaAI::setSearchTrace(const std::string& path) {
+    if (path.empty()) {
+        trace_writer_tw.reset();
+        return true;
+    }
+    auto writer = std::make_unique<SearchTraceWriter>();
+    if (!writer->open(path)) return false;
+    trace_writer_tw = std::move(writer);
+    std::cout << "[调试] 搜索追踪写入 " << path << std::endl;
+    return true;
+}
 
-    // 此操作会填充 precomputed_line_values_vl
-    precomputeValues(0, 0, 0, 0); // 参数: current_len_n, state_A, white_score_W, black_score_B
-    std::cout << "[调试] AlphaBetaAI 预计算 (fnd 逻辑) 完成。" << std::endl;
+void AlphaBetaAI::setSearchLimits(int time_limit_ms, long long node_limit) {
+    search_time_limit_ms = time_limit_ms;
+    search_node_limit = node_limit;
 }
 
-// 越界判断
-bool AlphaBetaAI::isOk(int r, int c) const {
-    return r >= 0 && r < ABAI_N && c >= 0 && c < ABAI_N;
+void AlphaBetaAI::setDifficultyLevel(int level) {
+    const ABAIDifficultyLevel& config = ABAI_DIFFICULTY_LEVELS[std::max(0, std::min(level, ABAI_DIFFICULTY_LEVEL_COUNT - 1))];
+    default_search_depth_U = config.search_depth;
+    default_branch_factor_V = config.branch_factor;
+    setSearchLimits(config.time_limit_ms, config.node_limit);
+    threat_solver_enabled_ts = config.threat_solver;
+    std::cout << "[调试] AlphaBetaAI 难度: " << config.name << " (U=" << config.search_depth << ", V=" << config.branch_factor
+              << ", 节点上限 " << config.node_limit << ", 每步最多 " << config.time_limit_ms << "ms)。" << std::endl;
 }
 
-// 预处理
-void AlphaBetaAI::precomputeValues(int current_len_n, int state_A, int white_score_W, int black_score_B) {
-    if (current_len_n < ABAI_VL_DIM1_SIZE && state_A < ABAI_B_STATES) {
-        precomputed_line_values_vl[current_len_n][state_A][0] = white_score_W; // 白方分数
-        precomputed_line_values_vl[current_len_n][state_A][1] = black_score_B; // 黑方分数
+// 每访问一个节点调用一次，预算用完时返回 true
+// 节点上限从第二轮迭代开始生效；时间上限在深度 1 也生效，此时采用根节点目前最好的走法
+bool AlphaBetaAI::checkSearchBudget() {
+    ++nodes_searched_ns;
+    if (search_aborted_sa) return true;
+    if (shared_stop_sp != nullptr) { // 辅助线程与后台思考听从主实例的停止信号，后台思考另有节点上限
+        search_aborted_sa = shared_stop_sp->load(std::memory_order_relaxed) ||
+                            (search_node_limit > 0 && completed_search_depth > 0 && nodes_searched_ns >= search_node_limit);
+        return search_aborted_sa;
     }
+    if (search_node_limit > 0 && completed_search_depth > 0 && nodes_searched_ns >= search_node_limit) {
+        search_aborted_sa = true;
+    } else if (search_time_limit_ms > 0 && (nodes_searched_ns & 1023) == 0) { // 每 1024 个节点看一次时钟
+        auto elapsed = std::chrono::steady_clock::now() - search_start_time;
+        if (std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() >= search_time_limit_ms) {
+            search_aborted_sa = true;
+        }
+    }
+    return search_aborted_sa;
+}
 
-    if (current_len_n == ABAI_MAX_LINE_LEN_FND) return; //最大深度
+void AlphaBetaAI::setThreadCount(int thread_count) {
+    if (thread_count < 1) thread_count = 1;
+    while (static_cast<int>(helper_engines_he.size()) > thread_count - 1) helper_engines_he.pop_back();
+    while (static_cast<int>(helper_engines_he.size()) < thread_count - 1) {
+        auto helper = std::make_unique<AlphaBetaAI>(default_search_depth_U, default_branch_factor_V, transposition_table_tt); // 共享主实例的置换表
+        helper->shared_stop_sp = &helper_stop_flag;
+        helper_engines_he.push_back(std::move(helper));
+    }
+    std::cout << "[调试] AlphaBetaAI 搜索线程数: " << thread_count << std::endl;
+}
 
-    for (int piece_type_value = 0; piece_type_value < 3; ++piece_type_value) { // 0: 空, 1: 黑 (内部表示), 2: 白 (内部表示)
-        if (current_len_n < ABAI_MAX_LINE_LEN_FND) { // fnd_gg_temp 的边界检查
-             fnd_gg_temp[current_len_n] = piece_type_value;
-        }
-        ++fnd_cx_temp[piece_type_value];
-        int next_W = white_score_W;
-        int next_B = black_score_B;
-
-        if (current_len_n >= 4) { // 5个棋子的窗口 (索引从 n-4 到 n)
-            // piece_type_value 1 代表黑棋，2 代表白棋
-            if (fnd_cx_temp[1] == 0 && fnd_cx_temp[2] < ABAI_V_WEIGHTS_SIZE) { // 没有黑棋，计算白棋分数
-                next_W += shape_scores_v[fnd_cx_temp[2]];
-            }
-            if (fnd_cx_temp[2] == 0 && fnd_cx_temp[1] < ABAI_V_WEIGHTS_SIZE) { // 没有白棋，计算黑棋分数
-                next_B += shape_scores_v[fnd_cx_temp[1]];
-            }
-            if (current_len_n - 4 < ABAI_MAX_LINE_LEN_FND) { // 边界检查
-                --fnd_cx_temp[fnd_gg_temp[current_len_n - 4]];
-            }
-        }
-        precomputeValues(current_len_n + 1, state_A * 3 + piece_type_value, next_W, next_B);
-        if (current_len_n >= 4) {
-             if (current_len_n - 4 < ABAI_MAX_LINE_LEN_FND) { // 边界检查
-                ++fnd_cx_temp[fnd_gg_temp[current_len_n - 4]];
-            }
+long long AlphaBetaAI::getLastSearchNodes() const {
+    long long total = nodes_searched_ns;
+    for (const auto& helper : helper_engines_he) total += helper->nodes_searched_ns;
+    return total;
+}
+
+long long AlphaBetaAI::getLastDepthTimeMs(int depth) const {
+    if (depth < 1 || depth > completed_search_depth || depth >= ABAI_MAX_PLY) return -1;
+    return depth_time_ms_dt[depth];
+}
+
+double AlphaBetaAI::getLastFirstMoveCutoffRate() const {
+    if (cutoff_node_count == 0) return 0.0;
+    return static_cast<double>(first_move_cutoff_count) / static_cast<double>(cutoff_node_count);
+}
+
+// 每次搜索开始时调用: 清空杀手走法，历史表减半以保留上一步的部分信息
+void AlphaBetaAI::resetMoveOrderingTables() {
+    for (auto& killers : killer_moves_km) killers.fill(-1);
+    for (auto& side_history : history_table_ht) {
+        for (int& value : side_history) value /= 2;
+    }
+    cutoff_node_count = 0;
+    first_move_cutoff_count = 0;
+    pvs_research_count = 0;
+    aspiration_research_count = 0;
+    quiescence_node_count = 0;
+    lmr_reduction_count = lmr_research_count = 0;
+    null_move_try_count = null_move_cutoff_count = null_move_verified_count = 0;
+#if ABAI_SEARCH_STATS
+    cutoff_index_count_ci.fill(0);
+    evaluation_update_count_eu = 0;
+#endif
+}
+
+// 汇总本次迭代加深的统计信息 (辅助线程已经结束)
+void AlphaBetaAI::collectSearchStatistics(long long elapsed_ms) {
+    SearchStatistics& stats = last_statistics_ls;
+    stats = SearchStatistics{};
+    stats.nodes = getLastSearchNodes();
+    stats.elapsed_ms = elapsed_ms;
+    stats.nodes_per_second = elapsed_ms > 0 ? static_cast<double>(stats.nodes) * 1000.0 / static_cast<double>(elapsed_ms) : 0.0;
+    stats.completed_depth = completed_search_depth;
+    for (int depth = 1; depth <= completed_search_depth; ++depth) {
+        stats.depth_time_ms[depth] = depth_time_ms_dt[depth];
+        stats.depth_nodes[depth] = depth_nodes_dn[depth];
+        if (depth > 1 && depth_nodes_dn[depth - 1] > 0) {
+            stats.branching_factor[depth] = static_cast<double>(depth_nodes_dn[depth]) / static_cast<double>(depth_nodes_dn[depth - 1]);
         }
-        --fnd_cx_temp[piece_type_value];
     }
+    stats.cutoff_nodes = cutoff_node_count;
+    stats.tt_probes = tt_probe_count;
+    stats.tt_hits = tt_hit_count;
+    stats.tt_cutoffs = tt_cutoff_count;
+#if ABAI_SEARCH_STATS
+    stats.detailed = true;
+    stats.cutoffs_by_move_index = cutoff_index_count_ci;
+    stats.evaluation_updates = evaluation_update_count_eu;
+#endif
+}
+
+// 走法引起剪枝: 记为本层的杀手走法，并按剩余深度的平方累加历史分
+void AlphaBetaAI::recordCutoffMove(int depth_n, int move_idx, int player_to_move_Op_dfs, int remaining_depth) {
+    std::array<int, ABAI_KILLER_SLOTS>& killers = killer_moves_km[depth_n];
+    if (killers[0] != move_idx) {
+        for (int k = ABAI_KILLER_SLOTS - 1; k > 0; --k) killers[k] = killers[k - 1];
+        killers[0] = move_idx;
+    }
+    history_table_ht[player_to_move_Op_dfs][move_idx] += remaining_depth * remaining_depth;
+}
+
+// 辅助线程从主实例复制当前局面 (棋盘、线状态、分数与哈希)
+void AlphaBetaAI::copySearchStateFrom(const AlphaBetaAI& source) {
+    aiPlayerColor_op = source.aiPlayerColor_op;
+    internal_board_bf = source.internal_board_bf;
+    line_states_g = source.line_states_g;
+    evaluator_ev = source.evaluator_ev;
+    pattern_classes_pc = source.pattern_classes_pc;
+    current_white_total_score = source.current_white_total_score;
+    current_black_total_score = source.current_black_total_score;
+    current_hash_key_zh = source.current_hash_key_zh;
+    near_stone_count_nc = source.near_stone_count_nc;
+    candidate_list_cl = source.candidate_list_cl;
+    candidate_pos_cp = source.candidate_pos_cp;
+    candidate_count_cc = source.candidate_count_cc;
+    cell_line_gain_lg = source.cell_line_gain_lg;
+    cell_gain_cg = source.cell_gain_cg;
+    current_branch_factor_V = source.current_branch_factor_V;
+    pvs_enabled_pe = source.pvs_enabled_pe;
+    quiescence_enabled_qs = source.quiescence_enabled_qs;
+    lmr_enabled_lr = source.lmr_enabled_lr;
+    null_move_enabled_nm = source.null_move_enabled_nm;
+    root_move_filter_active_rf = source.root_move_filter_active_rf;
+    root_move_allowed_rm = source.root_move_allowed_rm;
+}
+
+// 辅助线程的迭代加深: 与主线程错开深度，结果只通过共享置换表影响主线程
+void AlphaBetaAI::runHelperSearch(int target_depth, int thread_index) {
+    search_start_time = std::chrono::steady_clock::now();
+    nodes_searched_ns = 0;
+    search_aborted_sa = false;
+    completed_search_depth = 0;
+    previous_pv_length = 0;
+    resetMoveOrderingTables();
+
+    for (int depth = 1 + thread_index % 2; depth <= target_depth; ++depth) { // 奇数号线程跳过深度 1
+        current_search_depth_U = depth;
+        follow_pv_flag = true;
+        alphaBetaSearch(0, depth, -1000000000, 1000000000, aiPlayerColor_op);
+        if (search_aborted_sa) break;
+        completed_search_depth = depth;
+        previous_pv_length = pv_length_pl[0];
+        for (int k = 0; k < previous_pv_length; ++k) previous_pv_moves[k] = pv_table_pv[0][k];
+    }
+}
+
+// 置换表使用的键: 棋子哈希 + 轮到谁下 + AI 执子颜色 (评估分数是 AI 视角的) + 评估函数
+std::uint64_t AlphaBetaAI::searchKey(int player_to_move_Op_dfs) const {
+    return current_hash_key_zh ^ zobrist_side_keys_zs[player_to_move_Op_dfs] ^ zobrist_ai_color_keys_za[aiPlayerColor_op] ^
+           zobrist_evaluator_keys_ze[static_cast<int>(evaluator_ev)];
+}
+
+// 越界判断
+bool AlphaBetaAI::isOk(int r, int c) const {
+    return r >= 0 && r < ABAI_N && c >= 0 && c < ABAI_N;
 }
 
 // aiPlayerColor_op 对于黑棋是1，对于白棋是2
@@ -117,98 +422,145 @@ int AlphaBetaAI::calculateBoardScore() {
     // return 0; 
 }
 
+// (r, c) 所在四条线上、以它为中心的 9 格窗口的分数，乘以 weight_w 后计入总分
 void AlphaBetaAI::updateScoreContributionForLines(int r, int c, int weight_w) {
-    int L, R, d, e; // L,R为左右边界，d为长度，e为该线的状态编码
-
-    // 水平方向: line_states_g[0][行索引], p3_powers_p3 的索引是列索引
-    L = std::max(c - 4, 0); R = std::min(c + 4, ABAI_N - 1); d = R - L + 1;
-    if (d > 0 && d < ABAI_VL_DIM1_SIZE && L < ABAI_P3_POWERS_SIZE && d < ABAI_P3_POWERS_SIZE && r < ABAI_G_LINE_MAX_LEN) { // 检查 r 是否在 line_states_g[0] 的有效范围内
-        e = line_states_g[0][r] / p3_powers_p3[L] % p3_powers_p3[d];
-        if (e >=0 && e < ABAI_B_STATES) {
-             current_black_total_score += weight_w * precomputed_line_values_vl[d][e][1];
-             current_white_total_score += weight_w * precomputed_line_values_vl[d][e][0];
-        }
+    if (evaluator_ev == ABAIEvaluator::LINE_PATTERNS) {
+        updatePatternContribution(r, c, weight_w);
+        return;
     }
-
-    // 垂直方向: line_states_g[1][列索引], p3_powers_p3 的索引是行索引
-    L = std::max(r - 4, 0); R = std::min(r + 4, ABAI_N - 1); d = R - L + 1;
-    if (d > 0 && d < ABAI_VL_DIM1_SIZE && L < ABAI_P3_POWERS_SIZE && d < ABAI_P3_POWERS_SIZE && c < ABAI_G_LINE_MAX_LEN) { // 检查 c 是否在 line_states_g[1] 的有效范围内
-        e = line_states_g[1][c] / p3_powers_p3[L] % p3_powers_p3[d];
-         if (e >=0 && e < ABAI_B_STATES) {
-            current_black_total_score += weight_w * precomputed_line_values_vl[d][e][1];
-            current_white_total_score += weight_w * precomputed_line_values_vl[d][e][0];
-        }
-    }
-
-    // 主对角线方向: line_states_g[2][r+c], p3_powers_p3 的索引是 r (行索引)、
-    int diag_idx = r + c;
-    L = std::max({r - 4, 0, diag_idx - (ABAI_N - 1)}); R = std::min({r + 4, ABAI_N - 1, diag_idx});
-    d = R - L + 1;
-    if (d > 0 && d < ABAI_VL_DIM1_SIZE && L < ABAI_P3_POWERS_SIZE && d < ABAI_P3_POWERS_SIZE && diag_idx >=0 && diag_idx < ABAI_G_LINE_MAX_LEN) {
-        e = line_states_g[2][diag_idx] / p3_powers_p3[L] % p3_powers_p3[d];
-        if (e >=0 && e < ABAI_B_STATES) {
-            current_black_total_score += weight_w * precomputed_line_values_vl[d][e][1];
-            current_white_total_score += weight_w * precomputed_line_values_vl[d][e][0];
-        }
-    }
-
-    // 副对角线方向: line_states_g[3][r-c+N-1], p3_powers_p3 的索引是 r (行索引)
-    int anti_diag_idx = r - c + (ABAI_N - 1);
-    L = std::max({r - 4, 0, r - c}); R = std::min({r + 4, ABAI_N - 1, (ABAI_N - 1) + (r - c)});
-    d = R - L + 1;
-     if (d > 0 && d < ABAI_VL_DIM1_SIZE && L < ABAI_P3_POWERS_SIZE && d < ABAI_P3_POWERS_SIZE && anti_diag_idx >=0 && anti_diag_idx < ABAI_G_LINE_MAX_LEN) {
-        e = line_states_g[3][anti_diag_idx] / p3_powers_p3[L] % p3_powers_p3[d];
-        if (e >=0 && e < ABAI_B_STATES) {
-            current_black_total_score += weight_w * precomputed_line_values_vl[d][e][1];
-            current_white_total_score += weight_w * precomputed_line_values_vl[d][e][0];
-        }
+    const int idx = r * ABAI_N + c;
+    for (int dir = 0; dir < ABAI_G_LINES; ++dir) {
+        const ABAIWindowScores& scores = window_values_wv[lineWindow(dir, idx)];
+        current_black_total_score += weight_w * decodeWindowScore(scores.black);
+        current_white_total_score += weight_w * decodeWindowScore(scores.white);
     }
 }
 
 // piece_o 对于空是0，黑是1，白是2
 void AlphaBetaAI::updateAIInternalState(int r, int c, int piece_o) {
     if (!isOk(r,c)) return;
+#if ABAI_SEARCH_STATS
+    ++evaluation_update_count_eu;
+#endif
 
     updateScoreContributionForLines(r, c, -1); // 减去旧分数
+    current_hash_key_zh ^= zobrist_keys_zb[r * ABAI_N + c][internal_board_bf[r][c]] ^ zobrist_keys_zb[r * ABAI_N + c][piece_o];
+    int old_piece = internal_board_bf[r][c];
     internal_board_bf[r][c] = piece_o;
+    if (old_piece == 0 && piece_o != 0) updateCandidateSet(r, c, 1);       // 落子
+    else if (old_piece != 0 && piece_o == 0) updateCandidateSet(r, c, -1); // 撤销
 
-    int diff;
-    // 水平方向 g[0][r], p3 的索引是 c
-    if (r < ABAI_N && c < ABAI_P3_POWERS_SIZE) { 
-         diff = piece_o - (line_states_g[0][r] / p3_powers_p3[c] % 3);
-         line_states_g[0][r] += diff * p3_powers_p3[c];
+    // 四条线上该格的 2 位编码替换为新棋子
+    for (int dir = 0; dir < ABAI_G_LINES; ++dir) {
+        const ABAILineCoord& coord = ABAI_LINE_COORDS[r * ABAI_N + c][dir];
+        const int cell_shift = coord.shift + ABAI_WINDOW_CENTER_SHIFT;
+        std::uint64_t& line = line_states_g[dir][coord.line];
+        line = (line & ~(std::uint64_t(3) << cell_shift)) | (static_cast<std::uint64_t>(piece_o) << cell_shift);
     }
-    // 垂直方向 g[1][c], p3 的索引是 r
-    if (c < ABAI_N && r < ABAI_P3_POWERS_SIZE) { 
-        diff = piece_o - (line_states_g[1][c] / p3_powers_p3[r] % 3);
-        line_states_g[1][c] += diff * p3_powers_p3[r];
+
+    updateScoreContributionForLines(r, c, 1); // 加上新分数
+    refreshCellGainsAround(r, c);
+}
+
+// 重新计算 (r, c) 在 dir 方向的落子增益: 与 updateScoreContributionForLines 使用同一个窗口，
+// 比较该格为空与放上黑/白子时的窗口分数
+void AlphaBetaAI::refreshCellLineGain(int dir, int r, int c) {
+    std::array<int, 3>& gains = cell_line_gain_lg[r * ABAI_N + c][dir];
+    std::array<int, 3>& sums = cell_gain_cg[r * ABAI_N + c];
+    sums[1] -= gains[1];
+    sums[2] -= gains[2];
+    if (internal_board_bf[r][c] != 0) {
+        gains[1] = gains[2] = 0;
+        return;
     }
-    // 主对角线 g[2][r+c], p3 的索引是 r
-    int diag_idx = r + c;
-    if (diag_idx < ABAI_G_LINE_MAX_LEN && r < ABAI_P3_POWERS_SIZE) {
-        diff = piece_o - (line_states_g[2][diag_idx] / p3_powers_p3[r] % 3);
-        line_states_g[2][diag_idx] += diff * p3_powers_p3[r];
+
+    const std::uint32_t window = lineWindow(dir, r * ABAI_N + c); // 中心为空
+    const ABAIWindowScores& before = window_values_wv[window];
+    const ABAIWindowScores& black_after = window_values_wv[window | (1u << ABAI_WINDOW_CENTER_SHIFT)];
+    const ABAIWindowScores& white_after = window_values_wv[window | (2u << ABAI_WINDOW_CENTER_SHIFT)];
+    const int black_before = decodeWindowScore(before.black), white_before = decodeWindowScore(before.white);
+    gains[1] = (decodeWindowScore(black_after.black) - black_before) - 3 * (decodeWindowScore(black_after.white) - white_before);
+    gains[2] = (decodeWindowScore(white_after.white) - white_before) - 3 * (decodeWindowScore(white_after.black) - black_before);
+    sums[1] += gains[1];
+    sums[2] += gains[2];
+}
+
+// (r, c) 的棋子变化后，刷新四条线上 4 格以内的格子 (包括 (r, c) 本身) 在该方向的增益
+void AlphaBetaAI::refreshCellGainsAround(int r, int c) {
+    static const int dr[ABAI_G_LINES] = {0, 1, 1, 1};
+    static const int dc[ABAI_G_LINES] = {1, 0, -1, 1};
+    for (int dir = 0; dir < ABAI_G_LINES; ++dir) {
+        for (int k = -4; k <= 4; ++k) {
+            int rr = r + k * dr[dir], cc = c + k * dc[dir];
+            if (isOk(rr, cc)) refreshCellLineGain(dir, rr, cc);
+        }
     }
-    // 副对角线 g[3][r-c+N-1], p3 的索引是 r
-    int anti_diag_idx = r - c + (ABAI_N - 1);
-    if (anti_diag_idx >=0 && anti_diag_idx < ABAI_G_LINE_MAX_LEN && r < ABAI_P3_POWERS_SIZE) {
-        diff = piece_o - (line_states_g[3][anti_diag_idx] / p3_powers_p3[r] % 3);
-        line_states_g[3][anti_diag_idx] += diff * p3_powers_p3[r];
+}
+
+// 整个棋盘重算一次，交给批量评分内核 (结果与逐格调用 refreshCellLineGain 相同)
+void AlphaBetaAI::refreshAllCellGains() {
+    PlacementGains gains;
+    computePlacementGains(internal_board_bf, ABAI_SHAPE_SCORES, 3, gains);
+    for (int r = 0; r < ABAI_N; ++r) {
+        for (int c = 0; c < ABAI_N; ++c) {
+            std::array<int, 3>& sums = cell_gain_cg[r * ABAI_N + c];
+            sums.fill(0);
+            for (int dir = 0; dir < ABAI_G_LINES; ++dir) {
+                std::array<int, 3>& line_gains = cell_line_gain_lg[r * ABAI_N + c][dir];
+                line_gains[0] = 0;
+                line_gains[1] = gains.black[dir][r * PK_GAIN_STRIDE + c];
+                line_gains[2] = gains.white[dir][r * PK_GAIN_STRIDE + c];
+                sums[1] += line_gains[1];
+                sums[2] += line_gains[2];
+            }
+        }
     }
+}
 
-    updateScoreContributionForLines(r, c, 1); // 加上新分数
+// 维护候选集: 以 (r, c) 为中心的 5x5 范围内的格子的邻近棋子数加上 delta，
+// 再刷新这些格子是否属于候选集 (空位且邻近棋子数 > 0)
+void AlphaBetaAI::updateCandidateSet(int r, int c, int delta) {
+    for (int rr = std::max(r - ABAI_CANDIDATE_RANGE, 0); rr <= std::min(r + ABAI_CANDIDATE_RANGE, ABAI_N - 1); ++rr) {
+        for (int cc = std::max(c - ABAI_CANDIDATE_RANGE, 0); cc <= std::min(c + ABAI_CANDIDATE_RANGE, ABAI_N - 1); ++cc) {
+            int idx = rr * ABAI_N + cc;
+            near_stone_count_nc[idx] += delta;
+            bool should_be_candidate = internal_board_bf[rr][cc] == 0 && near_stone_count_nc[idx] > 0;
+            bool is_candidate = candidate_pos_cp[idx] >= 0;
+            if (should_be_candidate && !is_candidate) { // 加入列表末尾
+                candidate_pos_cp[idx] = candidate_count_cc;
+                candidate_list_cl[candidate_count_cc++] = idx;
+            } else if (!should_be_candidate && is_candidate) { // 用末尾元素填补空缺
+                int last_idx = candidate_list_cl[--candidate_count_cc];
+                candidate_list_cl[candidate_pos_cp[idx]] = last_idx;
+                candidate_pos_cp[last_idx] = candidate_pos_cp[idx];
+                candidate_pos_cp[idx] = -1;
+            }
+        }
+    }
 }
 
-void AlphaBetaAI::initializeAIStateFromBoard(const Board& externalBoard) {
+// 清空内部棋盘、线状态与增量评分 (不包括落子增益，由调用者整体重算)
+void AlphaBetaAI::clearAIState() {
     current_black_total_score = 0;
     current_white_total_score = 0;
+    current_hash_key_zh = 0;
+    near_stone_count_nc.fill(0);
+    candidate_pos_cp.fill(-1);
+    candidate_count_cc = 0;
 
     for(auto& row_bf : internal_board_bf) row_bf.fill(0); // 0 代表空 (内部约定)
-    for(auto& line_array : line_states_g) line_array.fill(0);
-
-    // p3_powers_p3 和 shape_scores_v 在构造函数中初始化。
-    // precomputeValues 在构造函数中调用。
+    // 所有线先填满墙，再把棋盘内的格子清空
+    for(auto& line_array : line_states_g) line_array.fill(~std::uint64_t(0));
+    for (int idx = 0; idx < ABAI_N * ABAI_N; ++idx) {
+        for (int dir = 0; dir < ABAI_G_LINES; ++dir) {
+            const ABAILineCoord& coord = ABAI_LINE_COORDS[idx][dir];
+            line_states_g[dir][coord.line] &= ~(std::uint64_t(3) << (coord.shift + ABAI_WINDOW_CENTER_SHIFT));
+        }
+    }
+}
 
+void AlphaBetaAI::initializeAIStateFromBoard(const Board& externalBoard) {
+    clearAIState();
     for (int r_idx = 0; r_idx < ABAI_N; ++r_idx) {
         for (int c_idx = 0; c_idx < ABAI_N; ++c_idx) {
             int piece_external = externalBoard.getPiece(r_idx, c_idx);
@@ -218,54 +570,246 @@ void AlphaBetaAI::initializeAIStateFromBoard(const Board& externalBoard) {
             }
         }
     }
+    refreshAllCellGains(); // 逐子落下时的增量刷新基于清空前的表，这里整体重算一次
     // aiPlayerColor_op 在 getMove 的开始处设置
     std::cout << "[调试] AlphaBetaAI 状态已初始化 (头文件V2)。 AI op=" << aiPlayerColor_op
               << ", 白方总分: " << current_white_total_score << ", 黑方总分: " << current_black_total_score << std::endl;
 }
 
+// 内部状态已由对局通知同步时直接沿用，否则从棋盘重建
+void AlphaBetaAI::syncAIStateWithBoard(const Board& externalBoard) {
+    if (!state_synced_ss) initializeAIStateFromBoard(externalBoard);
+}
+
+bool AlphaBetaAI::internalBoardMatches(const Board& externalBoard) const {
+    for (int r = 0; r < ABAI_N; ++r) {
+        for (int c = 0; c < ABAI_N; ++c) {
+            if (internal_board_bf[r][c] != map_to_internal_b_piece(externalBoard.getPiece(r, c))) return false;
+        }
+    }
+    return true;
+}
+
+// 分析任意局面 (不是对局中轮到 AI 的那一步) 前调用，之后内部状态就是 externalBoard。
+// 同步状态与它不同时先暂存到 analysis_backup_ab 再重建，返回 true，分析结束后必须调用 restoreSyncedState
+bool AlphaBetaAI::loadAnalysisPosition(const Board& externalBoard) {
+    if (!state_synced_ss) {
+        initializeAIStateFromBoard(externalBoard);
+        return false;
+    }
+    if (internalBoardMatches(externalBoard)) return false;
+    if (!analysis_backup_ab) {
+        analysis_backup_ab = std::make_unique<AlphaBetaAI>(default_search_depth_U, default_branch_factor_V, transposition_table_tt);
+    }
+    analysis_backup_ab->copySearchStateFrom(*this);
+    initializeAIStateFromBoard(externalBoard);
+    return true;
+}
+
+void AlphaBetaAI::restoreSyncedState() {
+    copySearchStateFrom(*analysis_backup_ab);
+}
+
+void AlphaBetaAI::onNewGame() {
+    stopPondering();
+    clearAIState();
+    refreshAllCellGains();
+    state_synced_ss = true;
+    synced_stone_count_sc = 0;
+}
+
+void AlphaBetaAI::onMovePlayed(int row, int col, int playerColor) {
+    // 对手没有走预期的应手: 后台搜索已无用，立即取消，不再占用 CPU
+    if (ponder_thread_pt.joinable() && playerColor != ponder_color_pc && row * ABAI_N + col != ponder_reply_pr) {
+        ++ponder_miss_count;
+        stopPondering();
+    }
+    if (!state_synced_ss || !isOk(row, col)) return;
+    updateAIInternalState(row, col, map_to_internal_b_piece(playerColor));
+    ++synced_stone_count_sc;
+}
+
+void AlphaBetaAI::onMoveUndone(int row, int col) {
+    stopPondering();
+    if (!state_synced_ss || !isOk(row, col)) return;
+    updateAIInternalState(row, col, 0);
+    --synced_stone_count_sc;
+}
+
 
 // player_to_move_Op_dfs 对于黑棋是1，白棋是2
-int AlphaBetaAI::alphaBetaSearch(int depth_n, int alpha_al, int beta_bt, int player_to_move_Op_dfs) {
-    if (depth_n == current_search_depth_U || abs(calculateBoardScore()) >= 1000000) {
-        return calculateBoardScore(); // 从 aiPlayerColor_op 的视角进行评估
+// depth_n 为距根节点的层数 (用于主变例与杀手走法)，remaining_depth 为剩余深度 (LMR/空着会额外减少)。
+// 开启追踪时，节点返回后写一条记录: 窗口、结果、子树节点数与 searchNode 给出的结束方式
+int AlphaBetaAI::alphaBetaSearch(int depth_n, int remaining_depth, int alpha_al, int beta_bt, int player_to_move_Op_dfs, bool allow_null_move) {
+    if (!trace_writer_tw) return searchNode(depth_n, remaining_depth, alpha_al, beta_bt, player_to_move_Op_dfs, allow_null_move);
+
+    const long long nodes_before = nodes_searched_ns;
+    const std::uint8_t entry_flags = trace_entry_flags_tf;
+    trace_entry_flags_tf = 0;
+    const int score = searchNode(depth_n, remaining_depth, alpha_al, beta_bt, player_to_move_Op_dfs, allow_null_move);
+
+    SearchTraceRecord record;
+    record.alpha = alpha_al;
+    record.beta = beta_bt;
+    record.score = score;
+    record.subtree_nodes = static_cast<std::uint32_t>(std::min<long long>(nodes_searched_ns - nodes_before, 0xFFFFFFFFLL));
+    record.move = depth_n == 0 ? STRACE_NO_MOVE : trace_path_tp[depth_n];
+    record.ply = static_cast<std::uint8_t>(depth_n);
+    record.depth = static_cast<std::int8_t>(std::max(-128, std::min(127, remaining_depth)));
+    record.reason = static_cast<std::uint8_t>(trace_reason_tr);
+    record.cut_index = static_cast<std::uint8_t>(std::min(trace_cut_index_tc, 255));
+    record.flags = static_cast<std::uint8_t>(trace_node_flags_tn | entry_flags);
+    record.side = static_cast<std::uint8_t>(player_to_move_Op_dfs);
+    trace_writer_tw->append(record);
+    return score;
+}
+
+int AlphaBetaAI::searchNode(int depth_n, int remaining_depth, int alpha_al, int beta_bt, int player_to_move_Op_dfs, bool allow_null_move) {
+    pv_length_pl[depth_n] = depth_n;
+    if (checkSearchBudget()) return traceExit(SearchTraceReason::ABORTED, 0); // 预算用完，结果会被丢弃
+
+    const int static_score = calculateBoardScore(); // 从 aiPlayerColor_op 的视角进行评估
+    if (depth_n >= ABAI_MAX_PLY - 1 || abs(static_score) >= 1000000) {
+        return traceExit(SearchTraceReason::TERMINAL, static_score);
+    }
+    if (remaining_depth <= 0) { // 到达名义深度，沿冲四/挡四继续搜索，避免水平线效应
+        return traceExit(SearchTraceReason::LEAF,
+                         quiescence_enabled_qs ? quiescenceSearch(depth_n, alpha_al, beta_bt, player_to_move_Op_dfs, ABAI_QUIESCENCE_MAX_PLY)
+                                               : static_score);
     }
 
-    // 生成候选走法并进行启发式评分
-    for (int r_idx = 0; r_idx < ABAI_N; ++r_idx) {
-        for (int c_idx = 0; c_idx < ABAI_N; ++c_idx) {
-            if (internal_board_bf[r_idx][c_idx] == 0) { // 如果是空位
-                updateAIInternalState(r_idx, c_idx, player_to_move_Op_dfs);
-                // 从 player_to_move_Op_dfs (当前轮到下棋的玩家) 的视角评分
-                // 这与 calculateBoardScore 不同，后者使用 aiPlayerColor_op (AI本身的颜色)
-                int current_eval_for_ww;
-                if (player_to_move_Op_dfs == 1) { // 黑棋的回合下这一步
-                    current_eval_for_ww = current_black_total_score - 3 * current_white_total_score;
-                } else { // 白棋的回合 (player_to_move_Op_dfs == 2)
-                    current_eval_for_ww = current_white_total_score - 3 * current_black_total_score;
-                }
-                candidate_scores_ww[r_idx * ABAI_N + c_idx] = current_eval_for_ww;
-                updateAIInternalState(r_idx, c_idx, 0); // 撤销走法
-            } else {
-                candidate_scores_ww[r_idx * ABAI_N + c_idx] = -1000000000; // 负十亿，极大的值
+    // 查询置换表: 足够深的结果可直接返回，否则至少拿到一个可优先尝试的走法
+    const std::uint64_t node_key = searchKey(player_to_move_Op_dfs);
+    const int alpha_orig = alpha_al;
+    const int beta_orig = beta_bt;
+    int hash_move = -1;
+    TTEntry tt_entry;
+    ++tt_probe_count;
+    if (transposition_table_tt->probe(node_key, tt_entry)) {
+        ++tt_hit_count;
+        hash_move = tt_entry.best_move;
+        // 根节点需要确定最佳走法，不直接截断
+        if (depth_n > 0 && tt_entry.depth >= remaining_depth) {
+            TTBound bound = tt_entry.bound();
+            if (bound == TTBound::EXACT ||
+                (bound == TTBound::LOWER && tt_entry.score >= beta_bt) ||
+                (bound == TTBound::UPPER && tt_entry.score <= alpha_al)) {
+                ++tt_cutoff_count;
+                return traceExit(SearchTraceReason::TT_CUTOFF, tt_entry.score);
             }
         }
     }
 
-    std::vector<int> move_indices(ABAI_N * ABAI_N); // 使用 vector 进行排序
-    std::iota(move_indices.begin(), move_indices.end(), 0); // 用 0, 1, 2... 填充
+    // 验证空着裁剪: 让当前一方停一手，若对方走完降低深度的搜索后仍然超出窗口，
+    // 再用降低深度的正常搜索验证一次，两者都超出才剪枝。
+    // 只用于零宽窗口节点；任一方有冲四 (存在成五点) 时停一手必然出错，不使用
+    const bool is_max_node = (player_to_move_Op_dfs == aiPlayerColor_op);
+    std::uint8_t node_trace_flags = 0;
+    if (null_move_enabled_nm && allow_null_move && depth_n > 0 && beta_bt - alpha_al == 1 &&
+        remaining_depth >= ABAI_NULL_MOVE_MIN_DEPTH &&
+        (is_max_node ? static_score >= beta_bt : static_score <= alpha_al) &&
+        !hasFourOnBoard()) {
+        ++null_move_try_count;
+        const int reduced_depth = remaining_depth - 1 - ABAI_NULL_MOVE_REDUCTION;
+        follow_pv_flag = false;
+        trace_path_tp[depth_n + 1] = STRACE_NULL_MOVE;
+        int null_score = alphaBetaSearch(depth_n + 1, reduced_depth, alpha_al, beta_bt, 3 - player_to_move_Op_dfs, false);
+        if (search_aborted_sa) return traceExit(SearchTraceReason::ABORTED, 0);
+        if (is_max_node ? null_score >= beta_bt : null_score <= alpha_al) {
+            ++null_move_cutoff_count;
+            trace_entry_flags_tf = STRACE_FLAG_VERIFY;
+            int verify_score = alphaBetaSearch(depth_n, remaining_depth - ABAI_NULL_MOVE_REDUCTION, alpha_al, beta_bt, player_to_move_Op_dfs, false);
+            if (search_aborted_sa) return traceExit(SearchTraceReason::ABORTED, 0);
+            if (is_max_node ? verify_score >= beta_bt : verify_score <= alpha_al) {
+                ++null_move_verified_count;
+                return traceExit(SearchTraceReason::NULL_MOVE_CUTOFF, is_max_node ? beta_bt : alpha_al);
+            }
+        }
+        node_trace_flags |= STRACE_FLAG_NULL_FAILED;
+        pv_length_pl[depth_n] = depth_n;
+    }
 
-    // 根据启发式评分对候选走法排序
-    std::sort(move_indices.begin(), move_indices.end(),
+    // 只生成候选集中的走法 (距离已有棋子 2 格以内的空位)
+    // 搜索子节点时会落子/撤销，候选集会随之变化，所以先复制到本层预先分配的走法缓冲区 (搜索中不分配堆内存)
+    int* move_indices = move_stack_ms[depth_n].data();
+    int move_count = candidate_count_cc;
+    std::copy(candidate_list_cl.begin(), candidate_list_cl.begin() + candidate_count_cc, move_indices);
+    if (move_count == 0 && internal_board_bf[ABAI_N / 2][ABAI_N / 2] == 0) { // 空棋盘只考虑天元
+        move_indices[move_count++] = (ABAI_N / 2) * ABAI_N + ABAI_N / 2;
+    }
+    // 算杀发现对方有必胜时，根节点只搜索能化解的走法 (就地压缩，全部被过滤时保留原列表)
+    if (depth_n == 0 && root_move_filter_active_rf) {
+        int allowed_count = static_cast<int>(std::count_if(move_indices, move_indices + move_count,
+            [&](int move_idx) { return root_move_allowed_rm[move_idx]; }));
+        if (allowed_count > 0) {
+            move_count = static_cast<int>(std::remove_if(move_indices, move_indices + move_count,
+                [&](int move_idx) { return !root_move_allowed_rm[move_idx]; }) - move_indices);
+        }
+    }
+    // 多主变例: 根节点去掉已被前面的线占用的走法
+    if (depth_n == 0 && root_exclusion_active_re) {
+        move_count = static_cast<int>(std::remove_if(move_indices, move_indices + move_count,
+            [&](int move_idx) { return root_move_excluded_me[move_idx]; }) - move_indices);
+    }
+    int* const moves_end = move_indices + move_count;
+
+    // 对候选走法进行启发式评分: 落子后的局面分数 = 当前分数 + 增量维护的落子增益，不需要落子/撤销
+    // 从 player_to_move_Op_dfs (当前轮到下棋的玩家) 的视角评分
+    // 这与 calculateBoardScore 不同，后者使用 aiPlayerColor_op (AI本身的颜色)
+    const int current_eval_for_ww = (player_to_move_Op_dfs == 1)
+        ? current_black_total_score - 3 * current_white_total_score   // 黑棋的回合下这一步
+        : current_white_total_score - 3 * current_black_total_score;  // 白棋的回合 (player_to_move_Op_dfs == 2)
+    for (const int* it = move_indices; it != moves_end; ++it) {
+        candidate_scores_ww[*it] = current_eval_for_ww + cell_gain_cg[*it][player_to_move_Op_dfs];
+    }
+
+    // 根据启发式评分选出排在前面的走法: 只有宽度上限以内的走法会被搜索，其余不必排序
+    const std::array<int, ABAI_N * ABAI_N>& history = history_table_ht[player_to_move_Op_dfs];
+    const int width_cap = std::min(branchWidthCap(remaining_depth, depth_n == 0), move_count);
+    std::partial_sort(move_indices, move_indices + width_cap, moves_end,
         [&](const int& a_idx, const int& b_idx) {
         if (candidate_scores_ww[a_idx] > candidate_scores_ww[b_idx]) return true;
         if (candidate_scores_ww[a_idx] < candidate_scores_ww[b_idx]) return false;
+        // 评分相同时，历史上更常引起剪枝的走法优先
+        if (history[a_idx] != history[b_idx]) return history[a_idx] > history[b_idx];
         // 平局打破规则：离中心点(7,7)更近的更好 (ABAI_N/2)
         int r_a = a_idx / ABAI_N, c_a = a_idx % ABAI_N;
         int r_b = b_idx / ABAI_N, c_b = b_idx % ABAI_N;
         // 意味着曼哈顿距离小的更好
-        return (std::abs(r_a - ABAI_N/2) + std::abs(c_a - ABAI_N/2)) < (std::abs(r_b - ABAI_N/2) + std::abs(c_b - ABAI_N/2));
+        int dist_a = std::abs(r_a - ABAI_N/2) + std::abs(c_a - ABAI_N/2);
+        int dist_b = std::abs(r_b - ABAI_N/2) + std::abs(c_b - ABAI_N/2);
+        if (dist_a != dist_b) return dist_a < dist_b;
+        return a_idx < b_idx; // 候选集的顺序随落子变化，用下标保证排序结果确定
     });
 
+    // 宽度按排序后的评分差距决定。下面把杀手、置换表与主变例走法提到最前面时，
+    // 若提前的走法原本在宽度之外，宽度加一，被挤到后面的高分走法 (可能是唯一的挡四) 仍会被搜索
+    int node_width = adaptiveBranchWidth(move_indices, width_cap, remaining_depth);
+    auto promote_move = [&](int move) {
+        int* it = std::find(move_indices, moves_end, move);
+        if (it == moves_end) return;
+        if (it - move_indices >= node_width) ++node_width;
+        std::rotate(move_indices, it, it + 1);
+    };
+
+    // 本层的杀手走法紧随置换表/主变例走法之后 (倒序旋转，使 killers[0] 排在最前)
+    for (int k = ABAI_KILLER_SLOTS - 1; k >= 0; --k) {
+        int killer = killer_moves_km[depth_n][k];
+        if (killer < 0 || internal_board_bf[killer / ABAI_N][killer % ABAI_N] != 0) continue;
+        promote_move(killer);
+    }
+    // 置换表中的最佳走法放在最前面
+    if (hash_move >= 0 && hash_move < ABAI_N * ABAI_N && internal_board_bf[hash_move / ABAI_N][hash_move % ABAI_N] == 0) {
+        promote_move(hash_move);
+    }
+    // 上一轮迭代的主变例走法优先级更高
+    const bool on_pv_node = follow_pv_flag;
+    int pv_move = -1;
+    if (on_pv_node && depth_n < previous_pv_length) {
+        pv_move = previous_pv_moves[depth_n];
+        if (pv_move >= 0 && internal_board_bf[pv_move / ABAI_N][pv_move % ABAI_N] == 0) promote_move(pv_move);
+    }
+
     int best_val_for_node_nm = alpha_al; 
     // 如果当前dfs的玩家不是AI本身，则这是一个MIN节点，对于AI来说，初始值为beta
     if (aiPlayerColor_op != player_to_move_Op_dfs) {
@@ -273,18 +817,82 @@ int AlphaBetaAI::alphaBetaSearch(int depth_n, int alpha_al, int beta_bt, int pla
     }
 
     int moves_explored_e = 0; // 已探索的走法计数
-    // 循环到分支因子
-    for (int e_loop_idx = 0; e_loop_idx < current_branch_factor_V && e_loop_idx < static_cast<int>(move_indices.size()); ++e_loop_idx) {
+    int best_move_idx = -1; // 本节点的最佳走法，写入置换表
+    int four_on_board = -1; // 是否有一方存在成五点，需要时才计算 (-1: 未计算)
+    int cutoff_move_number = 0; // 引起剪枝的是第几个走法，0 表示没有剪枝
+    // 循环到本节点的自适应宽度
+    for (int e_loop_idx = 0; e_loop_idx < node_width && e_loop_idx < move_count; ++e_loop_idx) {
         int move_idx = move_indices[e_loop_idx];
         int r = move_idx / ABAI_N;
         int c = move_idx % ABAI_N;
 
         if (internal_board_bf[r][c] == 0) { // 如果是空位
+            // 后期走法减少深度 (LMR): 只针对排序靠后、不形成也不阻挡活三/冲四的安静走法
+            int reduction = 0;
+            if (lmr_enabled_lr && depth_n > 0 && remaining_depth >= ABAI_LMR_MIN_DEPTH &&
+                moves_explored_e >= ABAI_LMR_FULL_DEPTH_MOVES &&
+                move_idx != hash_move && move_idx != pv_move &&
+                std::find(killer_moves_km[depth_n].begin(), killer_moves_km[depth_n].end(), move_idx) == killer_moves_km[depth_n].end() &&
+                isQuietMove(r, c, player_to_move_Op_dfs)) {
+                if (four_on_board < 0) four_on_board = hasFourOnBoard() ? 1 : 0;
+                if (four_on_board == 0) reduction = 1;
+            }
+
+            // 根节点先记下排在最前的走法，深度 1 在第一个走法搜完前用完时间也有走法可用
+            if (depth_n == 0 && is_max_node && !isOk(best_r_from_dfs, best_c_from_dfs)) {
+                best_r_from_dfs = r;
+                best_c_from_dfs = c;
+            }
             updateAIInternalState(r, c, player_to_move_Op_dfs);
-            int recursive_score_w = alphaBetaSearch(depth_n + 1, alpha_al, beta_bt, 3 - player_to_move_Op_dfs); // 得到对方玩家
+            trace_path_tp[depth_n + 1] = static_cast<std::int16_t>(move_idx);
+            follow_pv_flag = on_pv_node && move_idx == pv_move; // 只有主变例走法的子节点继续沿用主变例
+            const int child_depth = remaining_depth - 1;
+            int recursive_score_w = 0;
+            if (reduction > 0) {
+                ++lmr_reduction_count;
+                // 降低深度的零宽窗口搜索，结果超出窗口时恢复完整深度
+                if (is_max_node) {
+                    recursive_score_w = alphaBetaSearch(depth_n + 1, child_depth - reduction, alpha_al, alpha_al + 1, 3 - player_to_move_Op_dfs);
+                    if (!search_aborted_sa && recursive_score_w > alpha_al) reduction = 0;
+                } else {
+                    recursive_score_w = alphaBetaSearch(depth_n + 1, child_depth - reduction, beta_bt - 1, beta_bt, 3 - player_to_move_Op_dfs);
+                    if (!search_aborted_sa && recursive_score_w < beta_bt) reduction = 0;
+                }
+                if (reduction == 0) {
+                    ++lmr_research_count;
+                    node_trace_flags |= STRACE_FLAG_LMR_RESEARCH;
+                }
+                if (search_aborted_sa) reduction = 1; // 不再重搜，下面直接返回
+            }
+            if (reduction > 0) {
+                // 降低深度的搜索已确认该走法不会改变结果
+            } else if (!pvs_enabled_pe || moves_explored_e == 0 || beta_bt - alpha_al <= 1) {
+                recursive_score_w = alphaBetaSearch(depth_n + 1, child_depth, alpha_al, beta_bt, 3 - player_to_move_Op_dfs); // 得到对方玩家
+            } else if (is_max_node) {
+                // MAX 节点: 用 (alpha, alpha+1) 验证该走法不会超过 alpha，超过了再用完整窗口重搜
+                recursive_score_w = alphaBetaSearch(depth_n + 1, child_depth, alpha_al, alpha_al + 1, 3 - player_to_move_Op_dfs);
+                if (!search_aborted_sa && recursive_score_w > alpha_al && recursive_score_w < beta_bt) {
+                    ++pvs_research_count;
+                    node_trace_flags |= STRACE_FLAG_PVS_RESEARCH;
+                    recursive_score_w = alphaBetaSearch(depth_n + 1, child_depth, alpha_al, beta_bt, 3 - player_to_move_Op_dfs);
+                }
+            } else {
+                // MIN 节点: 用 (beta-1, beta) 验证该走法不会低于 beta
+                recursive_score_w = alphaBetaSearch(depth_n + 1, child_depth, beta_bt - 1, beta_bt, 3 - player_to_move_Op_dfs);
+                if (!search_aborted_sa && recursive_score_w < beta_bt && recursive_score_w > alpha_al) {
+                    ++pvs_research_count;
+                    node_trace_flags |= STRACE_FLAG_PVS_RESEARCH;
+                    recursive_score_w = alphaBetaSearch(depth_n + 1, child_depth, alpha_al, beta_bt, 3 - player_to_move_Op_dfs);
+                }
+            }
+            if (search_aborted_sa) {
+                updateAIInternalState(r, c, 0);
+                return traceExit(SearchTraceReason::ABORTED, 0);
+            }
+            int best_move_before = best_move_idx;
 
             // else { bt=nm=min(nm,w); }
-            if (player_to_move_Op_dfs == aiPlayerColor_op) { // AI 的 MAX 节点
+            if (is_max_node) { // AI 的 MAX 节点
                 if (depth_n == 0) { // 根节点
                     bool best_move_is_invalid_or_not_set = !isOk(best_r_from_dfs, best_c_from_dfs) ||
                                                            (isOk(best_r_from_dfs,best_c_from_dfs) && internal_board_bf[best_r_from_dfs][best_c_from_dfs] != 0);
@@ -294,67 +902,407 @@ int AlphaBetaAI::alphaBetaSearch(int depth_n, int alpha_al, int beta_bt, int pla
                         best_c_from_dfs = c;
                     }
                 }
+                if (recursive_score_w > best_val_for_node_nm || best_move_idx == -1) best_move_idx = move_idx;
                 best_val_for_node_nm = std::max(best_val_for_node_nm, recursive_score_w);
                 alpha_al = std::max(alpha_al, best_val_for_node_nm); // 更新alpha值
             } else { // AI 的 MIN 节点 (轮到对手下棋的搜索层)
+                if (recursive_score_w < best_val_for_node_nm || best_move_idx == -1) best_move_idx = move_idx;
                 best_val_for_node_nm = std::min(best_val_for_node_nm, recursive_score_w);
                 beta_bt = std::min(beta_bt, best_val_for_node_nm); // 更新beta值
             }
+            if (best_move_idx != best_move_before) { // 最佳走法变化，更新主变例
+                pv_table_pv[depth_n][depth_n] = move_idx;
+                for (int k = depth_n + 1; k < pv_length_pl[depth_n + 1]; ++k) {
+                    pv_table_pv[depth_n][k] = pv_table_pv[depth_n + 1][k];
+                }
+                pv_length_pl[depth_n] = std::max(pv_length_pl[depth_n + 1], depth_n + 1);
+            }
             updateAIInternalState(r, c, 0); // 撤销走法
             moves_explored_e++;
 
             if (alpha_al >= beta_bt) { // Alpha-Beta剪枝条件
+                ++cutoff_node_count;
+                if (moves_explored_e == 1) ++first_move_cutoff_count;
+                cutoff_move_number = moves_explored_e;
+#if ABAI_SEARCH_STATS
+                ++cutoff_index_count_ci[std::min(moves_explored_e, ABAI_STATS_CUTOFF_SLOTS) - 1];
+#endif
+                recordCutoffMove(depth_n, move_idx, player_to_move_Op_dfs, remaining_depth);
                 break; 
             }
         }
     }
     if (moves_explored_e == 0) { // 如果没有有效的走法被探索（例如，所有分支都被剪枝或没有空位）
-        return calculateBoardScore(); // 如果没有走法，当前棋盘分数是最佳猜测。
+        return traceExit(SearchTraceReason::NO_MOVES, calculateBoardScore(), 0, node_trace_flags); // 如果没有走法，当前棋盘分数是最佳猜测。
     }
+    const SearchTraceReason exit_reason =
+        cutoff_move_number > 0 ? SearchTraceReason::BETA_CUTOFF
+        : (best_val_for_node_nm > alpha_orig && best_val_for_node_nm < beta_orig) ? SearchTraceReason::EXACT
+        : SearchTraceReason::FAIL_LOW;
+    traceExit(exit_reason, 0, cutoff_move_number, node_trace_flags);
+
+    // 排除了部分走法的根节点结果不代表这个局面，不写入置换表
+    if (depth_n == 0 && root_exclusion_active_re) return best_val_for_node_nm;
+
+    // 写入置换表，边界类型由结果相对于原始窗口的位置决定
+    TTBound bound = TTBound::EXACT;
+    if (best_val_for_node_nm <= alpha_orig) bound = TTBound::UPPER;
+    else if (best_val_for_node_nm >= beta_orig) bound = TTBound::LOWER;
+    transposition_table_tt->store(node_key, remaining_depth, bound, best_val_for_node_nm, best_move_idx);
+
     return best_val_for_node_nm;
 }
 
 
+// 静态搜索: 只沿强制走法继续 (己方成五、挡对方的成五点、己方冲四)，extensions_left 为剩余的延伸层数。
+// 没有成五点需要防守时，当前一方可以选择不走强制走法，直接接受静态评估 (stand pat)。
+int AlphaBetaAI::quiescenceSearch(int depth_n, int alpha_al, int beta_bt, int player_to_move_Op_dfs, int extensions_left) {
+    pv_length_pl[depth_n] = depth_n;
+    if (checkSearchBudget()) return 0;
+    ++quiescence_node_count;
+
+    const int static_score = calculateBoardScore();
+    if (abs(static_score) >= 1000000) return static_score;
+    std::array<int, ABAI_N * ABAI_N> points;
+
+    // 当前一方能成五: 直接落子得到终局分数。延伸层数用完时也要检查，否则最后一层的必胜会被当成静态评估
+    if (collectFivePoints(player_to_move_Op_dfs, points) > 0) {
+        updateAIInternalState(points[0] / ABAI_N, points[0] % ABAI_N, player_to_move_Op_dfs);
+        int score = calculateBoardScore();
+        updateAIInternalState(points[0] / ABAI_N, points[0] % ABAI_N, 0);
+        return score;
+    }
+    if (extensions_left <= 0 || depth_n >= ABAI_MAX_PLY - 1) return static_score;
+    const bool is_max_node = (player_to_move_Op_dfs == aiPlayerColor_op);
+    const int opponent = 3 - player_to_move_Op_dfs;
+
+    // 走法放在本层的走法缓冲区中
+    int* moves = move_stack_ms[depth_n].data();
+    int move_count = 0;
+    if (collectFivePoints(opponent, points) > 0) {
+        moves[move_count++] = points[0]; // 必须去挡 (有两个成五点时挡哪个都会输)
+    } else {
+        if (is_max_node) {
+            if (static_score >= beta_bt) return beta_bt;
+            alpha_al = std::max(alpha_al, static_score);
+        } else {
+            if (static_score <= alpha_al) return alpha_al;
+            beta_bt = std::min(beta_bt, static_score);
+        }
+        // 己方冲四，活四排在前面 (插到开头，其余依次后移)
+        for (int i = 0; i < candidate_count_cc; ++i) {
+            int idx = candidate_list_cl[i];
+            int four_dirs;
+            int cls = classifyThreat(idx / ABAI_N, idx % ABAI_N, player_to_move_Op_dfs, four_dirs);
+            if (cls == ABAI_TC_OPEN_FOUR) {
+                std::copy_backward(moves, moves + move_count, moves + move_count + 1);
+                moves[0] = idx;
+                ++move_count;
+            } else if (cls == ABAI_TC_FOUR) {
+                moves[move_count++] = idx;
+            }
+        }
+        move_count = std::min(move_count, ABAI_QUIESCENCE_MAX_MOVES);
+    }
+
+    int best_val = is_max_node ? alpha_al : beta_bt;
+    for (int i = 0; i < move_count; ++i) {
+        int move_idx = moves[i];
+        int r = move_idx / ABAI_N, c = move_idx % ABAI_N;
+        updateAIInternalState(r, c, player_to_move_Op_dfs);
+        int score = quiescenceSearch(depth_n + 1, alpha_al, beta_bt, opponent, extensions_left - 1);
+        updateAIInternalState(r, c, 0);
+        if (search_aborted_sa) return 0;
+        if (is_max_node) {
+            best_val = std::max(best_val, score);
+            alpha_al = std::max(alpha_al, best_val);
+        } else {
+            best_val = std::min(best_val, score);
+            beta_bt = std::min(beta_bt, best_val);
+        }
+        if (alpha_al >= beta_bt) break;
+    }
+    return best_val;
+}
+
+
+// 分支宽度的上限随剩余深度增大，根节点的上限为 V
+int AlphaBetaAI::branchWidthCap(int remaining_depth, bool is_root) const {
+    return is_root ? current_branch_factor_V
+                   : std::min(current_branch_factor_V, ABAI_WIDTH_BASE + ABAI_WIDTH_PER_DEPTH * remaining_depth);
+}
+
+// 自适应分支宽度: 保留与最佳候选评分差距不超过阈值的走法。
+// sorted_moves 的前 move_count 个已按评分排好序 (move_count 不超过宽度上限)。
+// 阈值随剩余深度增大 (离根越近看得越宽)。
+// 冲四、必须防守等强制局面中评分差距很大，宽度自然收缩到最少的几手。
+int AlphaBetaAI::adaptiveBranchWidth(const int* sorted_moves, int move_count, int remaining_depth) const {
+    if (move_count == 0) return 0;
+    const int max_width = move_count;
+    const int gap_limit = ABAI_WIDTH_GAP_BASE + ABAI_WIDTH_GAP_PER_DEPTH * remaining_depth;
+    const int best_score = candidate_scores_ww[sorted_moves[0]];
+    int width = 1;
+    while (width < move_count && width < max_width && best_score - candidate_scores_ww[sorted_moves[width]] <= gap_limit) {
+        ++width;
+    }
+    return std::min(std::max(width, ABAI_MIN_BRANCH_WIDTH), max_width);
+}
+
+
+// 迭代加深: 依次搜索深度 1, 2, ... current_search_depth_U，直到预算用完
+// 始终采用最后一轮完整完成的迭代的结果，并用它的主变例为下一轮排序
+int AlphaBetaAI::runIterativeDeepening() {
+    const int target_depth = current_search_depth_U;
+    search_start_time = std::chrono::steady_clock::now();
+    nodes_searched_ns = 0;
+    search_aborted_sa = false;
+    completed_search_depth = 0;
+    previous_pv_length = 0;
+    resetMoveOrderingTables();
+
+    depth_time_ms_dt.fill(-1);
+    depth_nodes_dn.fill(0);
+    if (trace_writer_tw) {
+        SearchTraceRecord begin = {};
+        begin.move = STRACE_NO_MOVE;
+        begin.depth = static_cast<std::int8_t>(std::min(target_depth, 127));
+        begin.reason = static_cast<std::uint8_t>(SearchTraceReason::SEARCH_BEGIN);
+        begin.side = static_cast<std::uint8_t>(aiPlayerColor_op);
+        for (const auto& row : internal_board_bf) {
+            for (int piece : row) begin.subtree_nodes += piece != 0 ? 1 : 0;
+        }
+        trace_writer_tw->append(begin);
+    }
+
+    // 启动 Lazy SMP 辅助线程，它们一直搜索到主线程结束为止
+    helper_stop_flag.store(false, std::memory_order_relaxed);
+    std::vector<std::thread> helper_threads;
+    for (std::size_t i = 0; i < helper_engines_he.size(); ++i) {
+        helper_engines_he[i]->copySearchStateFrom(*this);
+        helper_threads.emplace_back(&AlphaBetaAI::runHelperSearch, helper_engines_he[i].get(),
+                                    target_depth, static_cast<int>(i) + 1);
+    }
+
+    int completed_best_r = -1, completed_best_c = -1;
+    int completed_score = 0;
+    completed_line_count_lc = 0;
+    std::array<int, ABAI_MAX_PLY> depth_scores; // 每一轮完成时的分数，供渴望窗口使用
+    // 本轮各条线的结果，整轮完成后才替换 line_*，中途用完预算时保留上一轮的结果
+    std::array<std::array<int, ABAI_MAX_PLY>, ABAI_MAX_MULTI_PV> depth_line_pv;
+    std::array<int, ABAI_MAX_MULTI_PV> depth_line_length;
+    std::array<int, ABAI_MAX_MULTI_PV> depth_line_score;
+    for (int depth = 1; depth <= target_depth; ++depth) {
+        current_search_depth_U = depth;
+        const long long depth_start_nodes = nodes_searched_ns;
+
+        int score = 0;
+        int line_count = 0;
+        for (int line = 0; line < multi_pv_count_mp; ++line) {
+            // 每条线沿用上一轮同一条线的主变例作为走法排序的起点
+            previous_pv_length = line < completed_line_count_lc ? line_pv_length_ll[line] : 0;
+            for (int k = 0; k < previous_pv_length; ++k) previous_pv_moves[k] = line_pv_moves_lp[line][k];
+
+            // 渴望窗口: 评估在奇偶层之间摆动明显，以同奇偶的上一轮 (depth-2) 分数为中心。
+            // 只用于第一条线，其余的线用完整窗口得到精确分数
+            int alpha = -1000000000, beta = 1000000000;
+            int window = aspiration_window_aw;
+            if (line == 0 && window > 0 && depth > 2 && depth - 2 <= completed_search_depth) {
+                alpha = depth_scores[depth - 2] - window;
+                beta = depth_scores[depth - 2] + window;
+            }
+            int line_score;
+            for (;;) {
+                best_r_from_dfs = -1;
+                best_c_from_dfs = -1;
+                follow_pv_flag = true;
+                line_score = alphaBetaSearch(0, depth, alpha, beta, aiPlayerColor_op);
+                if (search_aborted_sa) break;
+                if (line_score <= alpha && alpha > -1000000000) { // 低出窗口，放宽下界
+                    ++aspiration_research_count;
+                    window *= 4;
+                    alpha = window > 16 * aspiration_window_aw ? -1000000000 : line_score - window;
+                } else if (line_score >= beta && beta < 1000000000) { // 高出窗口，放宽上界
+                    ++aspiration_research_count;
+                    window *= 4;
+                    beta = window > 16 * aspiration_window_aw ? 1000000000 : line_score + window;
+                } else {
+                    break;
+                }
+            }
+            if (search_aborted_sa) break;
+            const bool has_move = isOk(best_r_from_dfs, best_c_from_dfs);
+            if (line > 0 && !has_move) break; // 根节点已没有可搜索的走法
+            if (line == 0) {
+                score = line_score;
+                completed_best_r = best_r_from_dfs;
+                completed_best_c = best_c_from_dfs;
+            }
+            // 记录这条线: 主变例以 best_r/c 开头时整条保留，否则 (例如所有走法都低出窗口) 只保留这一步
+            const int best_idx = has_move ? best_r_from_dfs * ABAI_N + best_c_from_dfs : -1;
+            depth_line_score[line] = line_score;
+            if (pv_length_pl[0] > 0 && pv_table_pv[0][0] == best_idx) {
+                depth_line_length[line] = pv_length_pl[0];
+                for (int k = 0; k < pv_length_pl[0]; ++k) depth_line_pv[line][k] = pv_table_pv[0][k];
+            } else {
+                depth_line_length[line] = has_move ? 1 : 0;
+                depth_line_pv[line][0] = best_idx;
+            }
+            ++line_count;
+            if (!has_move) break;
+            root_move_excluded_me[best_idx] = true; // 后面的线不再考虑这一步
+        }
+        // 恢复根节点的排除表 (只保留调用者指定的走法)
+        for (int line = 0; line < line_count; ++line) {
+            if (depth_line_length[line] > 0) root_move_excluded_me[depth_line_pv[line][0]] = false;
+        }
+
+        long long elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - search_start_time).count();
+        if (search_aborted_sa) {
+            if (completed_search_depth == 0) { // 深度 1 也没有完成
+                // 第一条线已搜完时沿用它的走法 (后面的线排除了这一步)，否则采用根节点目前最好的走法
+                if (line_count == 0) {
+                    completed_best_r = best_r_from_dfs;
+                    completed_best_c = best_c_from_dfs;
+                }
+                std::cout << "[AI 调试] 深度 1 未完成 (时间用完)，采用走法 ("
+                          << completed_best_r << "," << completed_best_c << ")。" << std::endl;
+                break;
+            }
+            std::cout << "[AI 调试] 深度 " << depth << " 未完成 (预算用完)，采用深度 "
+                      << completed_search_depth << " 的结果。" << std::endl;
+            break;
+        }
+
+        completed_search_depth = depth;
+        depth_time_ms_dt[depth] = elapsed_ms;
+        depth_nodes_dn[depth] = nodes_searched_ns - depth_start_nodes;
+        completed_score = score;
+        depth_scores[depth] = score;
+        completed_line_count_lc = line_count;
+        for (int line = 0; line < line_count; ++line) {
+            line_scores_ls[line] = depth_line_score[line];
+            line_pv_length_ll[line] = depth_line_length[line];
+            line_pv_moves_lp[line] = depth_line_pv[line];
+        }
+
+        std::cout << "[AI 调试] 迭代深度 " << depth << " 完成: 分数=" << score << ", 走法=("
+                  << completed_best_r << "," << completed_best_c << "), 节点数=" << nodes_searched_ns
+                  << ", 用时=" << elapsed_ms << "ms" << std::endl;
+
+        if (std::abs(score) >= 1000000) break; // 已分出胜负，无需继续加深
+        // 下一轮的耗时通常是本轮的数倍，已用掉一半预算时不再开始新一轮
+        if (search_time_limit_ms > 0 && elapsed_ms * 2 > search_time_limit_ms) break;
+    }
+
+    helper_stop_flag.store(true, std::memory_order_relaxed);
+    for (auto& helper_thread : helper_threads) helper_thread.join();
+    if (trace_writer_tw) trace_writer_tw->flush(); // 每次搜索结束都写完，程序运行中也能分析
+    collectSearchStatistics(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - search_start_time).count());
+
+    current_search_depth_U = target_depth;
+    best_r_from_dfs = completed_best_r;
+    best_c_from_dfs = completed_best_c;
+    return completed_score;
+}
+
+
 Point AlphaBetaAI::getMove(const Board& board, int playerColor) {
+    move_start_time_mt = std::chrono::steady_clock::now();
+    Point ponder_move;
+    if (takePonderResult(board, playerColor, ponder_move)) {
+        std::cout << "[AI] AlphaBetaAI 后台思考命中，走 行=" << ponder_move.row << ", 列=" << ponder_move.col << std::endl;
+        return ponder_move;
+    }
+
+    last_statistics_ls = SearchStatistics{}; // 不经过搜索 (快速路径、算杀) 时保持为空
     aiPlayerColor_op = map_to_internal_b_piece(playerColor); 
+    completed_line_count_lc = 0; // 主变例只在本次搜索之后有效 (供后台思考猜测应手)
 
-    int num_pieces_on_board = 0;
-    for(int r=0; r<ABAI_N; ++r) for(int c=0; c<ABAI_N; ++c)
-        if(map_to_internal_b_piece(board.getPiece(r,c)) != 0) num_pieces_on_board++;
+    int num_pieces_on_board = synced_stone_count_sc;
+    if (!state_synced_ss) {
+        num_pieces_on_board = 0;
+        for(int r=0; r<ABAI_N; ++r) for(int c=0; c<ABAI_N; ++c)
+            if(map_to_internal_b_piece(board.getPiece(r,c)) != 0) num_pieces_on_board++;
+    }
 
     best_r_from_dfs = -1; 
     best_c_from_dfs = -1;
 
     bool is_ai_black_first_move = (aiPlayerColor_op == 1 && num_pieces_on_board == 0);
+    Point instant_move;
 
     if (is_ai_black_first_move) { 
-        current_search_depth_U = 6;
-        current_branch_factor_V = 13;
         best_r_from_dfs = ABAI_N / 2; 
         best_c_from_dfs = ABAI_N / 2; 
-        std::cout << "[AI] AlphaBetaAI (头文件V2) 黑棋开局于中心。U="
-                  << current_search_depth_U << ", V=" << current_branch_factor_V << std::endl;
+        std::cout << "[AI] AlphaBetaAI (头文件V2) 黑棋开局于中心。" << std::endl;
+    } else if (findInstantMove(board, playerColor, instant_move)) {
+        // 能成五或必须挡四时不需要任何搜索
+        best_r_from_dfs = instant_move.row;
+        best_c_from_dfs = instant_move.col;
+        std::cout << "[AI 调试] 快速路径: 成五/挡四于 (" << best_r_from_dfs << "," << best_c_from_dfs << ")。" << std::endl;
     } else {
-        initializeAIStateFromBoard(board); 
-
-        if (aiPlayerColor_op == 1) { // AI是黑棋 (但不是第一步)
-            current_search_depth_U = default_search_depth_U; 
-            current_branch_factor_V = 25; // 黑棋的默认分支因子
-        } else { // AI是白棋 (aiPlayerColor_op == 2)
-            current_search_depth_U = default_search_depth_U; 
-            int original_V_for_white = 30; // 白棋的默认分支因子
-
-            if (num_pieces_on_board == 1) { // 这是AI白棋的 *第一手* 棋
-                current_branch_factor_V = 17; //  <--- 为白棋第一手减少分支因子
-                std::cout << "[AI 调试] AI 白方第一手棋，临时降低分支因子 V 至: " << current_branch_factor_V << std::endl;
-            } else {
-                current_branch_factor_V = original_V_for_white; // 白棋后续走法的正常V值
-            }
-        }
+        syncAIStateWithBoard(board); 
+
+        // 迭代加深受时间预算约束；每个节点的宽度由 adaptiveBranchWidth 决定，V 只是上限
+        current_search_depth_U = default_search_depth_U; 
+        current_branch_factor_V = default_branch_factor_V;
         
         std::cout << "[AI 调试] 中/后期游戏 (头文件V2)。 AI op=" << aiPlayerColor_op
                   << ", U=" << current_search_depth_U << ", V=" << current_branch_factor_V << std::endl;
-        alphaBetaSearch(0, -1000000000, 1000000000, aiPlayerColor_op); 
+
+        // 先算杀: 我方有必胜直接走，对方有必胜则只在能化解的走法中搜索
+        // 每步的时间上限包括算杀: 算杀最多用 1/ABAI_THREAT_TIME_SHARE，迭代加深用剩下的时间
+        ThreatSpaceResult& threats = threat_result_tr;
+        threats.status = ThreatSpaceResult::Status::NONE;
+        threat_deadline_active_td = search_time_limit_ms > 0;
+        threat_deadline_dl = move_start_time_mt + std::chrono::milliseconds(search_time_limit_ms / ABAI_THREAT_TIME_SHARE);
+        if (threat_solver_enabled_ts) runThreatSpaceSolver(aiPlayerColor_op, threats);
+        threat_deadline_active_td = false;
+        root_move_filter_active_rf = false;
+        if (threats.status == ThreatSpaceResult::Status::WIN && !threats.winning_line.empty()) {
+            best_r_from_dfs = threats.winning_line[0].row;
+            best_c_from_dfs = threats.winning_line[0].col;
+            std::cout << "[AI 调试] 算杀找到必胜 (" << (threats.by_vcf ? "VCF" : "VCT") << ", "
+                      << threats.winning_line.size() << " 手)。" << std::endl;
+        } else {
+            std::array<int, ABAI_N * ABAI_N> open_three_defences;
+            int open_three_defence_count = 0;
+            if (threats.status == ThreatSpaceResult::Status::DEFEND) {
+                root_move_allowed_rm.fill(false);
+                for (const Point& p : threats.defence_moves) root_move_allowed_rm[p.row * ABAI_N + p.col] = true;
+                root_move_filter_active_rf = true;
+                std::cout << "[AI 调试] 对方有" << (threats.by_vcf ? " VCF" : " VCT") << "，防守点 "
+                          << threats.defence_moves.size() << " 个。" << std::endl;
+            } else if (threat_solver_enabled_ts && generateThreatDefences(3 - aiPlayerColor_op, open_three_defences.data(), open_three_defence_count) &&
+                       open_three_defence_count > 0) {
+                // 算杀没有结论 (如节点用完) 时，至少保证应对对方的活三: 只搜索挡点与己方冲四
+                root_move_allowed_rm.fill(false);
+                for (int i = 0; i < open_three_defence_count; ++i) root_move_allowed_rm[open_three_defences[i]] = true;
+                root_move_filter_active_rf = true;
+                std::cout << "[AI 调试] 对方有活三，防守点 " << open_three_defence_count << " 个。" << std::endl;
+            }
+            transposition_table_tt->newSearch();
+            tt_probe_count = tt_hit_count = tt_cutoff_count = 0;
+            const int full_time_limit = search_time_limit_ms;
+            if (full_time_limit > 0) {
+                long long used_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - move_start_time_mt).count();
+                search_time_limit_ms = static_cast<int>(std::max<long long>(1, full_time_limit - used_ms));
+            }
+            runIterativeDeepening();
+            search_time_limit_ms = full_time_limit;
+            root_move_filter_active_rf = false;
+            std::cout << "[AI 调试] 置换表: 探测 " << tt_probe_count << " 次, 命中 " << tt_hit_count
+                      << " 次, 截断 " << tt_cutoff_count << " 次。" << std::endl;
+            std::cout << "[AI 调试] 剪枝节点 " << cutoff_node_count << " 个, 首着剪枝率 "
+                      << getLastFirstMoveCutoffRate() * 100.0 << "%。" << std::endl;
+            std::cout << "[AI 调试] LMR: 减少 " << lmr_reduction_count << " 次, 重搜 " << lmr_research_count
+                      << " 次; 空着: 尝试 " << null_move_try_count << " 次, 超出窗口 " << null_move_cutoff_count
+                      << " 次, 验证通过 " << null_move_verified_count << " 次; 静态搜索节点 "
+                      << quiescence_node_count << " 个。" << std::endl;
+        }
     }
 
     Point bestMovePoint;
@@ -386,3 +1334,169 @@ Point AlphaBetaAI::getMove(const Board& board, int playerColor) {
     std::cout << "[AI] AlphaBetaAI (头文件V2) 最终决策: 行=" << bestMovePoint.row << ", 列=" << bestMovePoint.col << std::endl;
     return bestMovePoint;
 }
+
+Point AlphaBetaAI::getMove(const Board& board, int playerColor, SearchStatistics& stats) {
+    Point move = getMove(board, playerColor);
+    stats = last_statistics_ls;
+    return move;
+}
+
+// 猜测 piece 的下一手: 候选集中落子后局面分数最高的点 (与走法排序的主关键字相同)，没有候选点时返回 -1
+int AlphaBetaAI::guessBestMove(int piece) const {
+    int best_idx = -1;
+    for (int i = 0; i < candidate_count_cc; ++i) {
+        const int idx = candidate_list_cl[i];
+        if (best_idx < 0 || cell_gain_cg[idx][piece] > cell_gain_cg[best_idx][piece] ||
+            (cell_gain_cg[idx][piece] == cell_gain_cg[best_idx][piece] && idx < best_idx)) {
+            best_idx = idx;
+        }
+    }
+    return best_idx;
+}
+
+void AlphaBetaAI::startPondering(const Board& board, int playerColor) {
+    stopPondering();
+    if (!ponder_enabled_pd) return;
+    const int ai_piece = map_to_internal_b_piece(playerColor);
+    if (ai_piece == 0) return;
+    const int opponent_color = (playerColor == BLACK_PIECE) ? WHITE_PIECE : BLACK_PIECE;
+
+    if (!ponder_engine_pe) {
+        ponder_engine_pe = std::make_unique<AlphaBetaAI>(default_search_depth_U, default_branch_factor_V, transposition_table_tt);
+        ponder_engine_pe->shared_stop_sp = &ponder_stop_flag; // 只听从停止信号，不受时间/节点预算限制
+    }
+    AlphaBetaAI& ponder = *ponder_engine_pe;
+    ponder.pvs_enabled_pe = pvs_enabled_pe;
+    ponder.aspiration_window_aw = aspiration_window_aw;
+    ponder.lmr_enabled_lr = lmr_enabled_lr;
+    ponder.null_move_enabled_nm = null_move_enabled_nm;
+    ponder.quiescence_enabled_qs = quiescence_enabled_qs;
+    ponder.threat_solver_enabled_ts = threat_solver_enabled_ts;
+    ponder.threat_node_limit_tl = threat_node_limit_tl;
+    ponder.evaluator_ev = evaluator_ev; // 在重建局面之前设置，总分按同一种评估计算
+    ponder.pattern_classes_pc = pattern_classes_pc;
+    ponder.search_time_limit_ms = 0; // 一直加深到目标深度 (或用完与本实例相同的节点上限)，直到被叫停
+    ponder.search_node_limit = search_node_limit;
+    ponder.aiPlayerColor_op = ai_piece;
+    ponder.initializeAIStateFromBoard(board);
+
+    // 预期的应手: 上一次搜索的主变例以刚走的棋开头时取它的第二步，否则按落子增益猜一个
+    int reply = -1;
+    if (completed_line_count_lc > 0 && line_pv_length_ll[0] >= 2) {
+        const int played = line_pv_moves_lp[0][0], expected = line_pv_moves_lp[0][1];
+        if (board.getPiece(played / ABAI_N, played % ABAI_N) == playerColor &&
+            board.getPiece(expected / ABAI_N, expected % ABAI_N) == EMPTY_PIECE) {
+            reply = expected;
+        }
+    }
+    if (reply < 0) reply = ponder.guessBestMove(3 - ai_piece);
+    if (reply < 0) return;
+
+    ponder_board_pb = board;
+    const int reply_r = reply / ABAI_N, reply_c = reply % ABAI_N;
+    if (!ponder_board_pb.placePiece(reply_r, reply_c, opponent_color)) return;
+    if (ponder_board_pb.checkWin(reply_r, reply_c, opponent_color) || ponder_board_pb.isFull()) return; // 对局会结束，不必思考
+
+    ponder_color_pc = playerColor;
+    ponder_reply_pr = reply;
+    ponder.completed_search_depth = 0;
+    ponder_stop_flag.store(false, std::memory_order_relaxed);
+    ponder_done_pd.store(false, std::memory_order_relaxed);
+    std::cout << "[AI 调试] 后台思考: 预期对手应手 (" << reply_r << "," << reply_c << ")。" << std::endl;
+    ponder_thread_pt = std::thread(&AlphaBetaAI::runPonderSearch, this);
+}
+
+void AlphaBetaAI::runPonderSearch() {
+    ponder_move_pm = ponder_engine_pe->getMove(ponder_board_pb, ponder_color_pc);
+    ponder_done_pd.store(true, std::memory_order_release);
+}
+
+void AlphaBetaAI::stopPondering() {
+    if (!ponder_thread_pt.joinable()) return;
+    ponder_stop_flag.store(true, std::memory_order_relaxed);
+    ponder_thread_pt.join();
+}
+
+// 局面与后台思考的局面相同时取用后台结果 (必要时等待)，否则取消后台思考并返回 false
+bool AlphaBetaAI::takePonderResult(const Board& board, int playerColor, Point& move) {
+    if (!ponder_thread_pt.joinable()) return false;
+    bool hit = (playerColor == ponder_color_pc);
+    for (int r = 0; r < ABAI_N && hit; ++r) {
+        for (int c = 0; c < ABAI_N && hit; ++c) hit = board.getPiece(r, c) == ponder_board_pb.getPiece(r, c);
+    }
+    if (!hit) {
+        ++ponder_miss_count;
+        stopPondering();
+        return false;
+    }
+
+    // 命中: 后台已经搜索了对手思考的整段时间，尚未完成时最多再等本步时间预算的一半，
+    // 留下另一半给后台结果不可用时的正常搜索
+    while (!ponder_done_pd.load(std::memory_order_acquire)) {
+        long long waited_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - move_start_time_mt).count();
+        if (search_time_limit_ms > 0 && waited_ms >= search_time_limit_ms / 2) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const bool finished = ponder_done_pd.load(std::memory_order_acquire);
+    stopPondering();
+    // 被提前叫停时至少要完成一轮迭代，否则结果只是后备走法，改为正常搜索 (置换表已经预热)
+    if (!finished && ponder_engine_pe->completed_search_depth < 1) return false;
+
+    ++ponder_hit_count;
+    move = ponder_move_pm;
+    last_statistics_ls = ponder_engine_pe->last_statistics_ls; // 统计的是后台搜索
+    // 沿用后台搜索的主变例，供下一次后台思考猜测应手
+    completed_line_count_lc = ponder_engine_pe->completed_line_count_lc > 0 ? 1 : 0;
+    line_pv_length_ll[0] = ponder_engine_pe->line_pv_length_ll[0];
+    line_pv_moves_lp[0] = ponder_engine_pe->line_pv_moves_lp[0];
+    return true;
+}
+
+std::vector<MultiPVLine> AlphaBetaAI::analyzeTopMoves(const Board& board, int playerColor, int k,
+                                                      const std::vector<Point>& excluded) {
+    // 提示/分析可能针对对局以外的局面: 按 board 分析，结束后恢复对局通知维护的内部状态
+    const bool restore = loadAnalysisPosition(board);
+    aiPlayerColor_op = map_to_internal_b_piece(playerColor);
+
+    current_search_depth_U = default_search_depth_U;
+    current_branch_factor_V = default_branch_factor_V;
+    multi_pv_count_mp = std::max(1, std::min(k, ABAI_MAX_MULTI_PV));
+    root_move_filter_active_rf = false;
+    root_exclusion_active_re = true;
+    for (const Point& p : excluded) {
+        if (isOk(p.row, p.col)) root_move_excluded_me[p.row * ABAI_N + p.col] = true;
+    }
+    std::cout << "[AI 调试] 多主变例分析: AI op=" << aiPlayerColor_op << ", 线数=" << multi_pv_count_mp
+              << ", U=" << current_search_depth_U << std::endl;
+
+    transposition_table_tt->newSearch();
+    tt_probe_count = tt_hit_count = tt_cutoff_count = 0;
+    runIterativeDeepening();
+
+    for (const Point& p : excluded) {
+        if (isOk(p.row, p.col)) root_move_excluded_me[p.row * ABAI_N + p.col] = false;
+    }
+    root_exclusion_active_re = false;
+    multi_pv_count_mp = 1;
+    if (restore) restoreSyncedState();
+
+    std::vector<MultiPVLine> lines;
+    for (int line = 0; line < completed_line_count_lc; ++line) {
+        if (line_pv_length_ll[line] == 0) continue;
+        MultiPVLine result;
+        result.score = line_scores_ls[line];
+        for (int ply = 0; ply < line_pv_length_ll[line]; ++ply) {
+            Point p;
+            p.row = line_pv_moves_lp[line][ply] / ABAI_N;
+            p.col = line_pv_moves_lp[line][ply] % ABAI_N;
+            result.pv.push_back(p);
+        }
+        result.move = result.pv[0];
+        lines.push_back(result);
+    }
+    // 后面的线排除了前面的走法，分数本应依次不增；自适应宽度可能造成轻微的逆序，按分数稳定排序
+    std::stable_sort(lines.begin(), lines.end(),
+                     [](const MultiPVLine& a, const MultiPVLine& b) { return a.score > b.score; });
+    return lines;
+}
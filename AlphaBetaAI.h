@@ -6,39 +6,301 @@
 #include "Player.h"
 #include "Board.h"
 #include "Constants.h" 
+#include "TranspositionTable.h"
+#include "SearchTrace.h"
 #include <vector>
 #include <array>
 #include <string>
 #include <algorithm> 
 #include <cmath>     
 #include <limits>    
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <atomic>
+#include <thread>
 
 const int ABAI_N = 15;           
-const int ABAI_B_STATES = 59049; 
-const int ABAI_MAX_LINE_LEN_FND = 9; 
-const int ABAI_VL_DIM1_SIZE = ABAI_MAX_LINE_LEN_FND + 1; 
 const int ABAI_V_WEIGHTS_SIZE = 6; 
-const int ABAI_P3_POWERS_SIZE = 15; 
+const int ABAI_FIVE_SCORE = 10000000;    // 五子连珠的窗口分数
+// 5 格窗口中有 n 个同色子、没有对方棋子时的分数
+inline constexpr std::array<int, ABAI_V_WEIGHTS_SIZE> ABAI_SHAPE_SCORES = {0, 1, 3, 9, 27, ABAI_FIVE_SCORE};
 const int ABAI_G_LINES = 4;         
 const int ABAI_G_LINE_MAX_LEN = 2 * ABAI_N -1; 
+const int ABAI_TT_DEFAULT_SIZE_MB = 16; // 置换表默认大小 (MB)
+const int ABAI_CANDIDATE_RANGE = 2;     // 候选走法: 与已有棋子切比雪夫距离不超过该值的空位
+const int ABAI_MAX_PLY = 64;             // 搜索树的最大层数 (主变例数组大小)
+const int ABAI_DEFAULT_TIME_LIMIT_MS = 3000; // 每步默认的思考时间上限 (毫秒)
+const int ABAI_KILLER_SLOTS = 2;          // 每层保存的杀手走法数
+const int ABAI_ASPIRATION_WINDOW = 64;    // 根节点渴望窗口的默认半宽，0 表示关闭
+const int ABAI_MAX_MULTI_PV = 16;         // 多主变例分析最多返回的线数
+const int ABAI_LMR_MIN_DEPTH = 3;         // 剩余深度不小于该值才使用后期走法减少 (LMR)
+const int ABAI_LMR_FULL_DEPTH_MOVES = 4;  // 每个节点前几个走法总是完整深度搜索
+const int ABAI_NULL_MOVE_MIN_DEPTH = 4;   // 剩余深度不小于该值才尝试空着裁剪
+const int ABAI_NULL_MOVE_REDUCTION = 2;   // 空着搜索与验证搜索额外减少的深度 (R)
+const int ABAI_MIN_BRANCH_WIDTH = 3;       // 每个节点至少搜索的走法数
+const int ABAI_WIDTH_BASE = 8;             // 非根节点的宽度上限: BASE + PER_DEPTH * 剩余深度 (且不超过 V)
+const int ABAI_WIDTH_PER_DEPTH = 4;
+const int ABAI_WIDTH_GAP_BASE = 32;        // 与最佳候选的评分差距阈值: GAP_BASE + GAP_PER_DEPTH * 剩余深度
+const int ABAI_WIDTH_GAP_PER_DEPTH = 16;
+const int ABAI_QUIESCENCE_MAX_PLY = 4;     // 静态搜索最多延伸的层数
+const int ABAI_QUIESCENCE_MAX_MOVES = 2;   // 静态搜索每个节点最多尝试的冲四走法数
+const int ABAI_LINE_WINDOW = 2 * 4 + 1;  // 以某格为中心、半径 4 的线段窗口长度
+const int ABAI_VCF_MAX_DEPTH = 12;       // VCF 最多连续冲四的步数 (进攻方)
+const int ABAI_VCT_MAX_DEPTH = 6;        // VCT 最多连续威胁的步数 (进攻方)
+const long long ABAI_THREAT_NODE_LIMIT = 10000; // 单次 VCF/VCT 求解的节点上限
+const int ABAI_THREAT_MAX_PLY = 2 * ABAI_VCF_MAX_DEPTH + 2; // 算杀递归的最大层数 (VCF 比 VCT 深)，也是必胜序列长度的上限
+const int ABAI_THREAT_TIME_SHARE = 4;    // getMove 中算杀最多使用每步时间上限的 1/ABAI_THREAT_TIME_SHARE
+const int ABAI_STATS_CUTOFF_SLOTS = 8;   // 按走法序号统计剪枝的槽数，最后一槽汇总更靠后的走法
 
+// 难度阶梯中的一级: AlphaBetaAI 的一组搜索预算 (见 setDifficultyLevel)。
+// 节点上限决定棋力，与机器快慢无关；时间上限是每步思考时间的上限，算杀与等待后台思考都计算在内
+struct ABAIDifficultyLevel {
+    const char* name;
+    int search_depth;      // 迭代加深的最大深度 U
+    int branch_factor;     // 每个节点的宽度上限 V
+    long long node_limit;  // 每步的搜索节点上限
+    int time_limit_ms;     // 每步的思考时间上限 (毫秒)
+    bool threat_solver;    // 搜索前是否算杀
+};
+const int ABAI_DIFFICULTY_LEVEL_COUNT = 5;
+const int ABAI_DEFAULT_DIFFICULTY_LEVEL = 3; // 与原来的"困难" (深度 5) 相当
+inline constexpr std::array<ABAIDifficultyLevel, ABAI_DIFFICULTY_LEVEL_COUNT> ABAI_DIFFICULTY_LEVELS = {{
+    {"入门", 2, 6, 1000, 100, false},
+    {"初级", 3, 10, 5000, 250, false},
+    {"中级", 4, 20, 30000, 500, true},
+    {"高级", 5, 30, 200000, 1500, true},
+    {"大师", 8, 30, 2000000, 3000, true},
+}};
+
+// 置为 1 时额外统计按走法序号的剪枝次数与评估更新次数 (SearchStatistics 中标为"详细"的字段)。
+// 默认关闭，此时这些计数不出现在搜索热路径中。CMake 选项 WIBYUAN_SEARCH_STATS 会定义它
+#ifndef ABAI_SEARCH_STATS
+#define ABAI_SEARCH_STATS 0
+#endif
+
+
+// --- 线状态的 2 位打包编码 ---
+// 每条线存成一个 64 位字，每格 2 位 (0 空, 1 黑, 2 白)，两端各填充 4 格墙 (编码 3)。
+// 以任一格为中心的 9 格窗口因此总是连续的 18 位，移位 + 掩码即可取出，超出棋盘的部分自然是墙。
+const int ABAI_LINE_PAD = 4;
+const int ABAI_WINDOW_BITS = 2 * ABAI_LINE_WINDOW;
+const int ABAI_WINDOW_CODES = 1 << ABAI_WINDOW_BITS;
+const int ABAI_WINDOW_CENTER_SHIFT = 2 * 4;      // 窗口中心格在窗口编码中的位移
+const std::uint32_t ABAI_WINDOW_MASK = ABAI_WINDOW_CODES - 1;
+
+// 格子在某个方向上所属的线，以及以它为中心的窗口在线状态字中的起始位
+struct ABAILineCoord {
+    std::uint8_t line;
+    std::uint8_t shift;
+};
+
+// [格子][方向] -> 线坐标。方向: 0 水平 (线号 r), 1 垂直 (线号 c), 2 r+c 相同, 3 r-c 相同 (线号 r-c+N-1)。
+// 格子在线上的序号从该线在棋盘内的第一格算起，所以窗口起始位 = 2 * 序号 (前面正好有 4 格墙)。
+constexpr std::array<std::array<ABAILineCoord, ABAI_G_LINES>, ABAI_N * ABAI_N> makeLineCoords() {
+    std::array<std::array<ABAILineCoord, ABAI_G_LINES>, ABAI_N * ABAI_N> coords{};
+    for (int r = 0; r < ABAI_N; ++r) {
+        for (int c = 0; c < ABAI_N; ++c) {
+            const int lines[ABAI_G_LINES] = {r, c, r + c, r - c + (ABAI_N - 1)};
+            const int positions[ABAI_G_LINES] = {c, r, r - (r + c > ABAI_N - 1 ? r + c - (ABAI_N - 1) : 0), r - (r > c ? r - c : 0)};
+            for (int dir = 0; dir < ABAI_G_LINES; ++dir) {
+                coords[r * ABAI_N + c][dir].line = static_cast<std::uint8_t>(lines[dir]);
+                coords[r * ABAI_N + c][dir].shift = static_cast<std::uint8_t>(2 * positions[dir]);
+            }
+        }
+    }
+    return coords;
+}
+inline constexpr std::array<std::array<ABAILineCoord, ABAI_G_LINES>, ABAI_N * ABAI_N> ABAI_LINE_COORDS = makeLineCoords();
+
+// 9 格窗口中所有完整 5 格窗口的分数之和，按颜色紧凑存储为 16 位:
+// 低 8 位是未成五窗口的分数之和 (最多 5 个窗口，每个不超过 27)，高 8 位是成五窗口的个数
+struct ABAIWindowScores {
+    std::uint16_t white;
+    std::uint16_t black;
+};
+static_assert(5 * ABAI_SHAPE_SCORES[4] <= 0xFF, "未成五窗口的分数之和必须放得进 8 位");
+
+inline int decodeWindowScore(std::uint16_t packed) {
+    if (packed <= 0xFF) return packed; // 绝大多数窗口没有成五
+    return (packed & 0xFF) + (packed >> 8) * ABAI_FIVE_SCORE;
+}
+
+// 在某个空位落子后，该子在一条线上形成的棋型 (由 classifyThreat 查表得到)
+enum ABAIThreatClass {
+    ABAI_TC_NONE = 0,
+    ABAI_TC_THREE = 1,     // 再下一手可形成活四 (两个成五点)
+    ABAI_TC_FOUR = 2,      // 一个成五点 (冲四)
+    ABAI_TC_OPEN_FOUR = 3, // 两个及以上成五点 (活四或同线双四)
+    ABAI_TC_FIVE = 4       // 成五
+};
+
+// 局面评估函数 (见 setEvaluator)
+enum class ABAIEvaluator {
+    SHAPE_WINDOWS = 0, // 每个 5 格窗口按其中的同色子数计分 (ABAI_SHAPE_SCORES)，默认
+    LINE_PATTERNS = 1  // 每个棋子按它在每条线上所处的棋型计分 (ABAI_PATTERN_SCORES)，能区分活四与冲四
+};
+
+// 棋子在一条线上所处的棋型: 只看经过该子的五连，以中心两侧各 4 格的窗口查表得到。
+// 数值越大越强；"活"与"眠"的区别是再下一手能否升一级为活的棋型
+enum ABAIPatternClass {
+    ABAI_PC_DEAD = 0,        // 经过该子已不可能连成五
+    ABAI_PC_ONE = 1,         // 还可能连成五，但再下一手也成不了活三/眠三
+    ABAI_PC_SLEEP_TWO = 2,   // 再下一手成眠三
+    ABAI_PC_LIVE_TWO = 3,    // 再下一手成活三
+    ABAI_PC_SLEEP_THREE = 4, // 再下一手成冲四
+    ABAI_PC_LIVE_THREE = 5,  // 再下一手成活四
+    ABAI_PC_RUSH_FOUR = 6,   // 一个成五点
+    ABAI_PC_LIVE_FOUR = 7,   // 两个及以上成五点
+    ABAI_PC_FIVE = 8,        // 成五
+    ABAI_PC_COUNT = 9
+};
+// 每个棋子在每个方向上的棋型分数 (一个活三的三个子各计一次)，成五与窗口计分一样判为终局
+inline constexpr std::array<int, ABAI_PC_COUNT> ABAI_PATTERN_SCORES = {0, 1, 2, 6, 6, 30, 30, 400, ABAI_FIVE_SCORE};
+
+// 算杀 (VCF/VCT) 的结果
+struct ThreatSpaceResult {
+    enum class Status {
+        NONE,    // 双方都没有找到必胜
+        WIN,     // 我方有必胜，winning_line 为进攻序列 (第一步即应走的棋)
+        DEFEND,  // 对方有必胜，defence_moves 为能化解的我方走法
+        LOST     // 对方有必胜，且找不到化解的走法
+    };
+    Status status = Status::NONE;
+    bool by_vcf = false;               // WIN/DEFEND/LOST 是否来自 VCF (否则来自 VCT)
+    std::vector<Point> winning_line;   // 双方交替的必胜序列 (WIN 时为我方，DEFEND/LOST 时为对方)
+    std::vector<Point> defence_moves;
+};
+
+// 多主变例分析中的一条线
+struct MultiPVLine {
+    Point move;              // 根节点走法
+    int score = 0;           // 精确分数 (分析方视角)
+    std::vector<Point> pv;   // 主变例，第一步即 move
+};
+
+// 一次搜索 (getMove / analyzeTopMoves) 的统计信息。节点数 (及每秒节点数) 包含 Lazy SMP 辅助线程，
+// 其余计数只来自主线程；快速路径与算杀直接得出走法时没有搜索，所有字段为 0
+struct SearchStatistics {
+    long long nodes = 0;                 // 访问的节点总数
+    long long elapsed_ms = 0;            // 迭代加深的总用时
+    double nodes_per_second = 0.0;
+    int completed_depth = 0;             // 完整完成的最大深度
+    std::array<long long, ABAI_MAX_PLY> depth_time_ms{};    // [d] 完成第 d 轮时的累计用时
+    std::array<long long, ABAI_MAX_PLY> depth_nodes{};      // [d] 第 d 轮迭代访问的节点数
+    std::array<double, ABAI_MAX_PLY> branching_factor{};    // [d] 有效分支因子 depth_nodes[d] / depth_nodes[d-1]
+    long long cutoff_nodes = 0;          // 发生 beta 剪枝的节点数
+    long long tt_probes = 0;
+    long long tt_hits = 0;
+    long long tt_cutoffs = 0;
+
+    // 详细字段，仅在 ABAI_SEARCH_STATS 为 1 时统计 (否则 detailed 为 false，以下均为 0)
+    bool detailed = false;
+    std::array<long long, ABAI_STATS_CUTOFF_SLOTS> cutoffs_by_move_index{}; // [i] 第 i+1 个走法引起剪枝的次数
+    long long evaluation_updates = 0;    // 落子/撤销时的增量评估更新次数
+};
 
 class AlphaBetaAI : public Player {
 public:
-    AlphaBetaAI(int searchDepthU_default = 5, int branchFactorV_default = 30);
+    AlphaBetaAI(int searchDepthU_default = 5, int branchFactorV_default = 30, int ttSizeMB_default = ABAI_TT_DEFAULT_SIZE_MB);
+    // 使用已有的置换表 (不再单独分配)，用于共享同一张表的辅助线程
+    AlphaBetaAI(int searchDepthU_default, int branchFactorV_default, std::shared_ptr<TranspositionTable> shared_tt);
+    ~AlphaBetaAI() override;
     Point getMove(const Board& board, int playerColor) override;
+    // 同 getMove，并返回这次搜索的统计信息
+    Point getMove(const Board& board, int playerColor, SearchStatistics& stats);
+
+    // 对局通知: 收到 onNewGame 后内部状态随每步棋增量更新，getMove 不再从棋盘重建
+    void onNewGame() override;
+    void onMovePlayed(int row, int col, int playerColor) override;
+    void onMoveUndone(int row, int col) override;
+
+    // 后台思考: 在对手思考时，用共享置换表的另一个实例搜索预期应手之后的局面。
+    // 对手走了预期的应手时 getMove 直接取用后台结果 (尚未搜完则最多再等本步的时间预算)，
+    // 否则立即取消，置换表中的结果仍可复用
+    void startPondering(const Board& board, int playerColor) override;
+    void stopPondering() override;
+    void setPondering(bool enabled) { ponder_enabled_pd = enabled; }
+    long long getPonderHitCount() const { return ponder_hit_count; }
+    long long getPonderMissCount() const { return ponder_miss_count; }
 
-private:
+    // 重新设置置换表大小 (MB)，会清空表中已有内容
+    void setTranspositionTableSize(int size_mb);
+    // 改用文件映射的持久置换表 (辅助线程与后台思考共享的也是这张表)。
+    // 同一台机器上的多个进程可同时使用同一文件，进程重启后已有的搜索结果仍可命中。
+    // 文件已存在且格式一致时沿用其大小与内容；失败时返回 false，继续使用内存中的表
+    bool openPersistentTranspositionTable(const std::string& path, int size_mb = ABAI_TT_DEFAULT_SIZE_MB);
+
+    // 设置迭代加深的预算: 时间上限 (毫秒) 与节点上限，<= 0 表示不限制
+    // 两者都不限制时，搜索会一直加深到 searchDepthU_default
+    void setSearchLimits(int time_limit_ms, long long node_limit);
+    // 按难度阶梯 ABAI_DIFFICULTY_LEVELS[level] 设置深度、宽度、预算与算杀 (超出范围时取最近的一级)
+    void setDifficultyLevel(int level);
+
+    // 主变例搜索 (PVS): 第一个走法用完整窗口，其余先用零宽窗口试探，失败再重搜
+    void setPrincipalVariationSearch(bool enabled) { pvs_enabled_pe = enabled; }
+    // 根节点渴望窗口的半宽，以同奇偶深度上一轮的分数为中心；<= 0 表示使用完整窗口
+    void setAspirationWindow(int half_width) { aspiration_window_aw = half_width; }
+    // 后期走法减少 (LMR) 与验证空着裁剪，默认开启
+    void setLateMoveReductions(bool enabled) { lmr_enabled_lr = enabled; }
+    // 名义深度之外的静态搜索 (只走冲四/挡四)，默认开启
+    void setQuiescenceSearch(bool enabled) { quiescence_enabled_qs = enabled; }
+    void setNullMovePruning(bool enabled) { null_move_enabled_nm = enabled; }
+    // getMove 搜索前的算杀与活三过滤，默认开启 (开启与否 getMove 都不分配堆内存)
+    void setThreatSolver(bool enabled) { threat_solver_enabled_ts = enabled; }
+    // 选择局面评估函数，默认 SHAPE_WINDOWS。切换时用新的评估重算当前局面的总分；
+    // 走法排序的落子增益始终按窗口计分
+    void setEvaluator(ABAIEvaluator evaluator);
+    ABAIEvaluator getEvaluator() const { return evaluator_ev; }
+
+    // 对给定局面做算杀: 先找 playerColor 的 VCF/VCT，再检查对方的 VCF/VCT 并求出防守点
+    ThreatSpaceResult analyzeThreats(const Board& board, int playerColor);
+
+    // 多主变例分析: 返回 playerColor 分数最高的前 k 个走法 (最多 ABAI_MAX_MULTI_PV 个)，按分数从高到低。
+    // 每轮迭代中第 i 条线排除前 i-1 条线的走法后搜索根节点，k 条线共享迭代加深、置换表与走法排序信息。
+    // excluded 中的走法不参与分析。只做搜索，不做算杀；搜索预算与 getMove 相同
+    std::vector<MultiPVLine> analyzeTopMoves(const Board& board, int playerColor, int k,
+                                             const std::vector<Point>& excluded = {});
+
+    // 设置搜索线程数 (Lazy SMP)，1 表示单线程。
+    // 额外的辅助线程各自持有一份棋盘与线状态副本，从根节点以错开的深度搜索，
+    // 所有线程共享同一张无锁置换表。
+    void setThreadCount(int thread_count);
+    int getThreadCount() const { return static_cast<int>(helper_engines_he.size()) + 1; }
+
+    // 搜索树追踪: 之后每次搜索的每个节点都写一条二进制记录到 path (覆盖原文件)，path 为空时关闭。
+    // 只追踪主线程，用 TraceSummary 工具离线分析。打开文件失败时返回 false
+    bool setSearchTrace(const std::string& path);
+
+    // 上一次搜索的统计信息
+    const SearchStatistics& getLastSearchStatistics() const { return last_statistics_ls; }
+    // 以下为单项统计 (供基准测试使用)
+    long long getLastSearchNodes() const;                 // 所有线程访问的节点总数
+    int getLastCompletedDepth() const { return completed_search_depth; }
+    long long getLastDepthTimeMs(int depth) const;        // 完成第 depth 轮迭代时的累计用时，未完成返回 -1
+    double getLastFirstMoveCutoffRate() const;            // 发生剪枝的节点中，第一个走法就剪枝的比例 (主线程)
+    long long getLastPVSResearchCount() const { return pvs_research_count; }               // 零宽窗口试探失败后的重搜次数
+    long long getLastAspirationResearchCount() const { return aspiration_research_count; } // 渴望窗口失败后的重搜次数
+    long long getLastQuiescenceNodeCount() const { return quiescence_node_count; }          // 静态搜索访问的节点数
+    long long getLastLMRCount() const { return lmr_reduction_count; }                       // 降低深度搜索的走法数
+    long long getLastLMRResearchCount() const { return lmr_research_count; }                // 其中超出窗口、恢复完整深度重搜的次数
+    long long getLastNullMoveTryCount() const { return null_move_try_count; }               // 尝试空着的节点数
+    long long getLastNullMoveCutoffCount() const { return null_move_cutoff_count; }         // 空着搜索超出窗口的次数
+    long long getLastNullMoveVerifiedCount() const { return null_move_verified_count; }     // 其中通过验证搜索、实际剪枝的次数
+
+protected: // ProofNumberAI 复用棋盘、线状态与棋型识别
     // --- 成员变量 ---
     int aiPlayerColor_op; 
 
     std::array<std::array<int, ABAI_N>, ABAI_N> internal_board_bf; 
-    std::array<std::array<std::array<int, 2>, ABAI_B_STATES>, ABAI_VL_DIM1_SIZE> precomputed_line_values_vl; 
-    std::array<int, ABAI_MAX_LINE_LEN_FND> fnd_gg_temp; 
-    std::array<int, 3> fnd_cx_temp; 
-    std::array<int, ABAI_V_WEIGHTS_SIZE> shape_scores_v;  
-    std::array<int, ABAI_P3_POWERS_SIZE> p3_powers_p3; 
-    std::array<std::array<int, ABAI_G_LINE_MAX_LEN>, ABAI_G_LINES> line_states_g; 
+    // 以 9 格窗口的 2 位编码为下标的线段分数表 (ABAI_WINDOW_CODES 项)。
+    // 表是不可变的，进程内只构建一次，所有实例与辅助线程共享，这里只保存指针
+    const ABAIWindowScores* window_values_wv;
+    // 棋型评估: [棋子-1][9 格窗口编码] -> 中心棋子的 ABAIPatternClass。
+    // 与窗口分数表一样进程内共享，第一次选用 LINE_PATTERNS 时才构建
+    ABAIEvaluator evaluator_ev;
+    const std::array<std::uint8_t, ABAI_WINDOW_CODES>* pattern_classes_pc;
+    std::array<std::array<std::uint64_t, ABAI_G_LINE_MAX_LEN>, ABAI_G_LINES> line_states_g; // 2 位打包的线状态
     
     int current_white_total_score;
     int current_black_total_score; 
@@ -46,20 +308,209 @@ private:
     int best_c_from_dfs; 
     
     std::array<int, ABAI_N * ABAI_N> candidate_scores_ww; 
+
+    // --- 增量候选评分 ---
+    // 在空位落下黑/白子后，从落子方视角的局面分数 (己方总分 - 3 * 对方总分) 的变化量。
+    // 落子只影响同一条线上 4 格以内、且方向相同的线段，所以按方向分别保存，
+    // 由 updateAIInternalState 只刷新这些格子；有子的格子记为 0。
+    std::array<std::array<std::array<int, 3>, ABAI_G_LINES>, ABAI_N * ABAI_N> cell_line_gain_lg; // [格子][方向][棋子]
+    std::array<std::array<int, 3>, ABAI_N * ABAI_N> cell_gain_cg; // [格子][棋子]，四个方向之和
+
+    // --- Zobrist 哈希与置换表 ---
+    std::array<std::array<std::uint64_t, 3>, ABAI_N * ABAI_N> zobrist_keys_zb; // [格子][棋子]，空位的键为 0
+    std::array<std::uint64_t, 3> zobrist_side_keys_zs; // 轮到哪一方下棋 (1:黑, 2:白)
+    std::array<std::uint64_t, 3> zobrist_ai_color_keys_za; // AI 执子颜色，评估是 AI 视角的，需要区分
+    std::array<std::uint64_t, 2> zobrist_evaluator_keys_ze; // [ABAIEvaluator]，两种评估的分数不能混用
+    std::uint64_t current_hash_key_zh; // 当前局面的哈希值，由 updateAIInternalState 增量维护
+
+    // --- 增量候选集 ---
+    // 候选集 = 距离某个棋子 ABAI_CANDIDATE_RANGE 格以内的空位，在落子/撤销时增量维护，
+    // 以无序列表 + 反向下标的形式存储，加入和删除都是 O(1)
+    std::array<int, ABAI_N * ABAI_N> near_stone_count_nc; // 每个格子周围 5x5 范围内的棋子数
+    std::array<int, ABAI_N * ABAI_N> candidate_list_cl;   // 候选格子列表 (前 candidate_count_cc 项有效)
+    std::array<int, ABAI_N * ABAI_N> candidate_pos_cp;    // 格子在列表中的位置，不在列表中为 -1
+    int candidate_count_cc;
+    std::shared_ptr<TranspositionTable> transposition_table_tt; // 与辅助线程共享
+    long long tt_probe_count;
+    long long tt_hit_count;
+    long long tt_cutoff_count;
     
     int current_search_depth_U;
     int current_branch_factor_V;
     int default_search_depth_U;
     int default_branch_factor_V;
 
+    // --- 迭代加深 ---
+    int search_time_limit_ms;      // 时间预算，<= 0 表示不限制
+    long long search_node_limit;   // 节点预算，<= 0 表示不限制
+    long long nodes_searched_ns;   // 本次 getMove 已访问的节点数
+    bool search_aborted_sa;        // 预算用完后置为 true，当前这一轮迭代的结果作废
+    std::chrono::steady_clock::time_point search_start_time;
+    std::chrono::steady_clock::time_point move_start_time_mt; // getMove 开始的时刻，每步的时间上限从这里算起
+    int completed_search_depth;    // 最后一轮完整完成的深度
+
+    // 三角形主变例 (PV) 表: pv_table_pv[ply] 保存从 ply 层开始的最佳走法序列
+    std::array<std::array<int, ABAI_MAX_PLY>, ABAI_MAX_PLY> pv_table_pv;
+    std::array<int, ABAI_MAX_PLY> pv_length_pl;
+    // 上一轮完成的迭代得到的主变例，用于下一轮的走法排序
+    std::array<int, ABAI_MAX_PLY> previous_pv_moves;
+    int previous_pv_length;
+
+    // --- 多主变例 ---
+    int multi_pv_count_mp;                   // 每轮迭代搜索的线数，getMove 为 1
+    bool root_exclusion_active_re;           // 根节点是否排除 root_move_excluded_me 中的走法
+    std::array<bool, ABAI_N * ABAI_N> root_move_excluded_me;
+    int completed_line_count_lc;             // 最近完成的一轮迭代得到的线数
+    std::array<std::array<int, ABAI_MAX_PLY>, ABAI_MAX_MULTI_PV> line_pv_moves_lp; // 各条线的主变例
+    std::array<int, ABAI_MAX_MULTI_PV> line_pv_length_ll;
+    std::array<int, ABAI_MAX_MULTI_PV> line_scores_ls;
+    bool follow_pv_flag; // 当前节点是否位于上一轮的主变例上
+    std::array<long long, ABAI_MAX_PLY> depth_time_ms_dt; // 每一轮迭代完成时的累计用时
+    std::array<long long, ABAI_MAX_PLY> depth_nodes_dn;   // 每一轮迭代访问的节点数
+    SearchStatistics last_statistics_ls;                  // 最近一次搜索的统计，由 collectSearchStatistics 填写
+
+    // --- 走法排序: 杀手走法与历史表 ---
+    std::array<std::array<int, ABAI_KILLER_SLOTS>, ABAI_MAX_PLY> killer_moves_km; // 每层最近引起剪枝的走法，-1 表示空
+    std::array<std::array<int, ABAI_N * ABAI_N>, 3> history_table_ht;              // [下棋方][格子] 引起剪枝的累计权重
+    long long cutoff_node_count;       // 发生剪枝的节点数
+    long long first_move_cutoff_count; // 其中由第一个走法引起剪枝的节点数
+#if ABAI_SEARCH_STATS
+    std::array<long long, ABAI_STATS_CUTOFF_SLOTS> cutoff_index_count_ci; // 按引起剪枝的走法序号计数
+    long long evaluation_update_count_eu;                                 // updateAIInternalState 的调用次数
+#endif
+
+    // --- PVS 与渴望窗口 ---
+    bool pvs_enabled_pe;
+    int aspiration_window_aw;
+    long long pvs_research_count;
+    long long aspiration_research_count;
+
+    // --- 静态搜索 ---
+    bool quiescence_enabled_qs;
+    long long quiescence_node_count;
+
+    // --- LMR 与验证空着裁剪 ---
+    bool lmr_enabled_lr;
+    bool null_move_enabled_nm;
+    long long lmr_reduction_count;
+    long long lmr_research_count;
+    long long null_move_try_count;
+    long long null_move_cutoff_count;
+    long long null_move_verified_count;
+
+    // --- 走法缓冲区 ---
+    // 每层一块固定大小的走法数组，alphaBetaSearch 与静态搜索都在其中生成走法，搜索过程中不分配堆内存
+    std::array<std::array<int, ABAI_N * ABAI_N>, ABAI_MAX_PLY> move_stack_ms;
+
+    // --- Lazy SMP ---
+    std::vector<std::unique_ptr<AlphaBetaAI>> helper_engines_he; // 辅助线程使用的搜索实例
+    std::atomic<bool> helper_stop_flag;       // 主线程完成后通知辅助线程停止
+    const std::atomic<bool>* shared_stop_sp;  // 辅助实例指向主实例的停止标志，主实例为 nullptr
+
+    // --- 算杀 ---
+    long long threat_nodes_tn;               // 本次求解已访问的节点数
+    long long threat_node_limit_tl;          // 节点上限 (超过时间时置 0，之后的求解立即结束)
+    bool threat_deadline_active_td;          // getMove 中的算杀受 threat_deadline_dl 限制
+    std::chrono::steady_clock::time_point threat_deadline_dl;
+    bool threat_solver_enabled_ts;           // getMove 是否先做算杀
+    bool root_move_filter_active_rf;         // 根节点是否只允许 root_move_allowed_rm 中的走法
+    std::array<bool, ABAI_N * ABAI_N> root_move_allowed_rm;
+    // 每层一条必胜序列 (前 threat_line_length_tk[ply] 项有效)，第 ply 层的序列 = 本层走法 + 第 ply+1 层的序列
+    std::array<std::array<int, ABAI_THREAT_MAX_PLY>, ABAI_THREAT_MAX_PLY + 1> threat_lines_tk;
+    std::array<int, ABAI_THREAT_MAX_PLY + 1> threat_line_length_tk;
+    ThreatSpaceResult threat_result_tr;      // getMove 的算杀结果，两个列表在构造时预留容量，算杀不分配堆内存
+
+    // --- 对局通知 ---
+    bool state_synced_ss;                    // 内部棋盘是否由 onNewGame/onMovePlayed 维护 (与外部棋盘一致)
+    int synced_stone_count_sc;               // 同步状态下棋盘上的棋子数
+    std::unique_ptr<AlphaBetaAI> analysis_backup_ab; // 分析其他局面时暂存同步状态 (只用 copySearchStateFrom，不搜索)
+
+    // --- 后台思考 ---
+    bool ponder_enabled_pd;
+    std::unique_ptr<AlphaBetaAI> ponder_engine_pe;   // 后台搜索实例 (共享置换表)
+    std::thread ponder_thread_pt;
+    std::atomic<bool> ponder_stop_flag;             // 通知后台搜索停止 (ponder_engine_pe 的 shared_stop_sp 指向它)
+    std::atomic<bool> ponder_done_pd;               // 后台搜索已自然结束
+    Board ponder_board_pb;                          // 预期应手之后的局面
+    int ponder_color_pc;                            // 后台搜索替哪一方 (外部棋子值) 找棋
+    int ponder_reply_pr;                            // 预期的对手应手 (r * N + c)
+    Point ponder_move_pm;                           // 后台搜索的结果
+    long long ponder_hit_count;
+    long long ponder_miss_count;
+
+    // --- 搜索树追踪 ---
+    std::unique_ptr<SearchTraceWriter> trace_writer_tw;      // 为空表示不追踪 (辅助线程与后台思考从不追踪)
+    std::array<std::int16_t, ABAI_MAX_PLY + 1> trace_path_tp; // [ply] 到达该层节点的走法
+    std::uint8_t trace_entry_flags_tf;                        // 交给下一个节点记录的标记 (验证搜索)
+    SearchTraceReason trace_reason_tr;                        // 以下三项由 searchNode 返回前写入
+    int trace_cut_index_tc;
+    std::uint8_t trace_node_flags_tn;
+
     // --- 私有方法 ---
     bool isOk(int r, int c) const;
-    void precomputeValues(int current_len_n, int state_A, int white_score_W, int black_score_B); 
+    // (r, c) 在 dir 方向上、以它为中心的 9 格窗口编码
+    std::uint32_t lineWindow(int dir, int idx) const {
+        const ABAILineCoord& coord = ABAI_LINE_COORDS[idx][dir];
+        return static_cast<std::uint32_t>(line_states_g[dir][coord.line] >> coord.shift) & ABAI_WINDOW_MASK;
+    }
     int calculateBoardScore(); 
     void updateScoreContributionForLines(int r, int c, int weight_w); 
-    void updateAIInternalState(int r, int c, int piece_o); 
-    int alphaBetaSearch(int depth_n, int alpha_al, int beta_bt, int player_to_move_Op_dfs); 
+    void updatePatternContribution(int r, int c, int weight_w); // 实现在 AlphaBetaAIPatterns.cpp
+    void updateAIInternalState(int r, int c, int piece_o);
+    void refreshCellLineGain(int dir, int r, int c);
+    void refreshCellGainsAround(int r, int c);
+    void refreshAllCellGains(); 
+    int alphaBetaSearch(int depth_n, int remaining_depth, int alpha_al, int beta_bt, int player_to_move_Op_dfs, bool allow_null_move = true);
+    int searchNode(int depth_n, int remaining_depth, int alpha_al, int beta_bt, int player_to_move_Op_dfs, bool allow_null_move);
+    // searchNode 的每个返回点都经过这里，记下节点的结束方式供追踪记录使用
+    int traceExit(SearchTraceReason reason, int score, int cut_index = 0, std::uint8_t flags = 0) {
+        trace_reason_tr = reason;
+        trace_cut_index_tc = cut_index;
+        trace_node_flags_tn = flags;
+        return score;
+    }
     void initializeAIStateFromBoard(const Board& externalBoard); 
+    void clearAIState();
+    void syncAIStateWithBoard(const Board& externalBoard);
+    bool internalBoardMatches(const Board& externalBoard) const;
+    bool loadAnalysisPosition(const Board& externalBoard);
+    void restoreSyncedState();
+    int guessBestMove(int piece) const;
+    void runPonderSearch();
+    bool takePonderResult(const Board& board, int playerColor, Point& move);
+    void initializeZobristKeys();
+    std::uint64_t persistentTableTag() const;
+    void updateCandidateSet(int r, int c, int delta);
+    bool checkSearchBudget();
+    int runIterativeDeepening();
+    void copySearchStateFrom(const AlphaBetaAI& source);
+    void runHelperSearch(int target_depth, int thread_index);
+    std::uint64_t searchKey(int player_to_move_Op_dfs) const;
+    int quiescenceSearch(int depth_n, int alpha_al, int beta_bt, int player_to_move_Op_dfs, int extensions_left);
+    int branchWidthCap(int remaining_depth, bool is_root) const;
+    int adaptiveBranchWidth(const int* sorted_moves, int move_count, int remaining_depth) const;
+    void resetMoveOrderingTables();
+    void collectSearchStatistics(long long elapsed_ms);
+    void recordCutoffMove(int depth_n, int move_idx, int player_to_move_Op_dfs, int remaining_depth);
+
+    // --- 算杀 (VCF/VCT)，实现在 AlphaBetaAIThreats.cpp ---
+    int threatWindowKey(int r, int c, int dir) const;
+    int classifyThreat(int r, int c, int piece, int& four_dirs) const;
+    bool makesFive(int r, int c, int piece) const;
+    bool makesWinningThreat(int r, int c, int piece);
+    bool isQuietMove(int r, int c, int piece) const;
+    bool hasFourOnBoard() const;
+    int collectFivePoints(int piece, std::array<int, ABAI_N * ABAI_N>& points) const;
+    void runThreatSpaceSolver(int piece, ThreatSpaceResult& result);
+    bool threatBudgetExceeded();
+    bool solveThreatAttack(int attacker, int depth_left, bool allow_threes, int ply);
+    bool solveThreatDefence(int attacker, int depth_left, bool allow_threes, int ply);
+    void prependThreatLine(int ply, int move);
+    int findThreatDefences(int attacker, bool allow_threes, int* defences);
+    static int scanFivePoints(const Board& board, int piece, std::array<int, ABAI_N * ABAI_N>& points);
+    bool findInstantMove(const Board& board, int playerColor, Point& move) const;
+    bool generateThreatDefences(int attacker, int* defences, int& defence_count);
+    int generateThreatMoves(int attacker, bool allow_threes, int* moves) const;
 };
 
 #endif // ALPHABETAAI_H
@@ -0,0 +1,146 @@
+// Copyright (c) 2025 wibyuan
+// Licensed under the MIT License (see LICENSE for details)
+//
+// AlphaBetaAI 的棋型评估 (ABAIEvaluator::LINE_PATTERNS)。
+// 每个棋子在每个方向上，以它为中心的 9 格窗口 (与 lineWindow 相同) 查表得到棋型，按 ABAI_PATTERN_SCORES 计分。
+// 落子只会改变同一条线上 4 格以内的棋子的棋型，所以增量更新只重算这些棋子。
+#include "AlphaBetaAI.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+const std::uint8_t PATTERN_UNKNOWN = 0xFF; // 构建过程中尚未分类的编码
+
+// 窗口 (9 格，中心为 4) 中经过中心的 piece 连子长度
+int centerRunLength(const int* cells, int piece) {
+    int count = 1;
+    for (int k = 3; k >= 0 && cells[k] == piece; --k) ++count;
+    for (int k = 5; k < ABAI_LINE_WINDOW && cells[k] == piece; ++k) ++count;
+    return count;
+}
+
+// 棋型表: 以 9 格窗口编码为下标，记录中心棋子在这条线上的棋型。
+// 中心不是该颜色的编码不会被查询；棋型由"再下一手后最强的棋型"递推，结果记在表中避免重复计算
+struct LinePatternTable {
+    std::array<std::array<std::uint8_t, ABAI_WINDOW_CODES>, 2> classes; // [piece-1][code]
+
+    LinePatternTable() {
+        for (auto& piece_classes : classes) piece_classes.fill(PATTERN_UNKNOWN);
+        // 与窗口分数表相同: 墙只出现在窗口两端，每端最多 4 格
+        for (int piece = 1; piece <= 2; ++piece) {
+            for (int left = 0; left <= 4; ++left) {
+                for (int right = 0; right <= 4; ++right) {
+                    const int inner = ABAI_LINE_WINDOW - left - right;
+                    int state_count = 1;
+                    for (int i = 1; i < inner; ++i) state_count *= 3;
+                    for (int state = 0; state < state_count; ++state) {
+                        std::uint32_t code = 0;
+                        int rest = state;
+                        for (int i = 0; i < ABAI_LINE_WINDOW; ++i) {
+                            int cell;
+                            if (i < left || i >= left + inner) cell = 3;
+                            else if (i == 4) cell = piece;
+                            else { cell = rest % 3; rest /= 3; }
+                            code |= static_cast<std::uint32_t>(cell) << (2 * i);
+                        }
+                        classify(code, piece);
+                    }
+                }
+            }
+            for (std::uint8_t& cls : classes[piece - 1]) {
+                if (cls == PATTERN_UNKNOWN) cls = ABAI_PC_DEAD;
+            }
+        }
+    }
+
+    int classify(std::uint32_t code, int piece) {
+        std::uint8_t& memo = classes[piece - 1][code];
+        if (memo != PATTERN_UNKNOWN) return memo;
+
+        int cells[ABAI_LINE_WINDOW];
+        for (int i = 0; i < ABAI_LINE_WINDOW; ++i) cells[i] = (code >> (2 * i)) & 3;
+        int result;
+        if (centerRunLength(cells, piece) >= 5) {
+            result = ABAI_PC_FIVE;
+        } else {
+            // 经过中心的成五点
+            int five_points = 0;
+            for (int e = 0; e < ABAI_LINE_WINDOW; ++e) {
+                if (cells[e] != 0) continue;
+                cells[e] = piece;
+                if (centerRunLength(cells, piece) >= 5) ++five_points;
+                cells[e] = 0;
+            }
+            if (five_points >= 2) {
+                result = ABAI_PC_LIVE_FOUR;
+            } else if (five_points == 1) {
+                result = ABAI_PC_RUSH_FOUR;
+            } else {
+                // 再下一手后最强的棋型降两级: 活四 -> 活三, 冲四 -> 眠三, 活三 -> 活二, 眠三 -> 眠二，
+                // 只能成二的记为 ONE；无论怎么下都不再经过中心成五的是 DEAD
+                int best_child = ABAI_PC_DEAD;
+                for (int e = 0; e < ABAI_LINE_WINDOW; ++e) {
+                    if (cells[e] != 0) continue;
+                    best_child = std::max(best_child, classify(code | (static_cast<std::uint32_t>(piece) << (2 * e)), piece));
+                }
+                result = best_child >= ABAI_PC_SLEEP_TWO ? std::max(best_child - 2, static_cast<int>(ABAI_PC_ONE)) : ABAI_PC_DEAD;
+            }
+        }
+        memo = static_cast<std::uint8_t>(result);
+        return result;
+    }
+};
+
+// 进程内只构建一次，多个引擎实例与搜索线程共享
+const LinePatternTable& linePatternTable() {
+    static const LinePatternTable table;
+    return table;
+}
+
+} // namespace
+
+// (r, c) 所在四条线上 4 格以内的棋子 (包括 (r, c) 本身) 在该方向的棋型分数，乘以 weight_w 后计入总分
+void AlphaBetaAI::updatePatternContribution(int r, int c, int weight_w) {
+    static const int dr[ABAI_G_LINES] = {0, 1, 1, 1};
+    static const int dc[ABAI_G_LINES] = {1, 0, -1, 1};
+    for (int dir = 0; dir < ABAI_G_LINES; ++dir) {
+        for (int k = -4; k <= 4; ++k) {
+            const int rr = r + k * dr[dir], cc = c + k * dc[dir];
+            if (!isOk(rr, cc)) continue;
+            const int piece = internal_board_bf[rr][cc];
+            if (piece == 0) continue;
+            const int score = ABAI_PATTERN_SCORES[pattern_classes_pc[piece - 1][lineWindow(dir, rr * ABAI_N + cc)]];
+            if (piece == 1) current_black_total_score += weight_w * score;
+            else current_white_total_score += weight_w * score;
+        }
+    }
+}
+
+void AlphaBetaAI::setEvaluator(ABAIEvaluator evaluator) {
+    if (evaluator == evaluator_ev) return;
+    stopPondering(); // 后台搜索使用的是旧的评估
+    if (evaluator == ABAIEvaluator::LINE_PATTERNS && pattern_classes_pc == nullptr) {
+        pattern_classes_pc = linePatternTable().classes.data();
+    }
+
+    std::cout << "[调试] AlphaBetaAI 评估函数: " << (evaluator == ABAIEvaluator::LINE_PATTERNS ? "棋型" : "窗口计分") << std::endl;
+    if (!state_synced_ss) { // 内部状态会在下一次 getMove 时从棋盘重建
+        evaluator_ev = evaluator;
+        return;
+    }
+
+    // 对局通知维护的内部状态: 用旧的评估把棋子逐个拿掉 (总分回到 0)，再用新的评估逐个放回
+    const std::array<std::array<int, ABAI_N>, ABAI_N> stones = internal_board_bf;
+    for (int r = 0; r < ABAI_N; ++r) {
+        for (int c = 0; c < ABAI_N; ++c) {
+            if (stones[r][c] != 0) updateAIInternalState(r, c, 0);
+        }
+    }
+    evaluator_ev = evaluator;
+    for (int r = 0; r < ABAI_N; ++r) {
+        for (int c = 0; c < ABAI_N; ++c) {
+            if (stones[r][c] != 0) updateAIInternalState(r, c, stones[r][c]);
+        }
+    }
+}
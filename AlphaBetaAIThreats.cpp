@@ -0,0 +1,467 @@
+// Copyright (c) 2025 wibyuan
+// Licensed under the MIT License (see LICENSE for details)
+//
+// AlphaBetaAI 的算杀部分: 基于 line_states_g 的棋型识别与 VCF/VCT 求解。
+// VCF (连续冲四) 只在能形成成五点的走法上分支；VCT (连续威胁) 还允许活三。
+// 防守方只考虑能化解威胁的点和自己的冲四，因此几手之内就能证明很深的必胜。
+#include "AlphaBetaAI.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// 四个方向的步长: 0 水平, 1 垂直, 2 副对角线 (r+c 不变), 3 主对角线 (r-c 不变)
+// 与 line_states_g 的四组线一一对应
+const int THREAT_DIR_DR[ABAI_G_LINES] = {0, 1, 1, 1};
+const int THREAT_DIR_DC[ABAI_G_LINES] = {1, 0, -1, 1};
+
+const int THREAT_KEY_STATES = 1 << 16; // 中心两侧各 4 格，每格 2 位
+
+// 窗口 (9 格，中心为 4) 中 idx 处视为 piece 时，经过 idx 的同色连子长度
+int runLengthThrough(const int* cells, int idx, int piece) {
+    int count = 1;
+    for (int k = idx - 1; k >= 0 && cells[k] == piece; --k) ++count;
+    for (int k = idx + 1; k < ABAI_LINE_WINDOW && cells[k] == piece; ++k) ++count;
+    return count;
+}
+
+// 窗口中 piece 的成五点数量
+int windowFivePoints(const int* cells, int piece) {
+    int count = 0;
+    for (int e = 0; e < ABAI_LINE_WINDOW; ++e) {
+        if (cells[e] == 0 && runLengthThrough(cells, e, piece) >= 5) ++count;
+    }
+    return count;
+}
+
+// 棋型表: 以中心两侧 8 格的状态为下标，记录 piece 落在中心后的棋型
+struct ThreatPatternTable {
+    std::array<std::array<std::uint8_t, THREAT_KEY_STATES>, 2> classes; // [piece-1][key]
+
+    ThreatPatternTable() {
+        int cells[ABAI_LINE_WINDOW];
+        for (int piece = 1; piece <= 2; ++piece) {
+            for (int key = 0; key < THREAT_KEY_STATES; ++key) {
+                for (int j = 0; j < 8; ++j) {
+                    cells[j < 4 ? j : j + 1] = (key >> (2 * j)) & 3;
+                }
+                cells[4] = piece;
+                classes[piece - 1][key] = static_cast<std::uint8_t>(classify(cells, piece));
+            }
+        }
+    }
+
+    static int classify(int* cells, int piece) {
+        if (runLengthThrough(cells, 4, piece) >= 5) return ABAI_TC_FIVE;
+        int five_points = windowFivePoints(cells, piece);
+        if (five_points >= 2) return ABAI_TC_OPEN_FOUR;
+        if (five_points == 1) return ABAI_TC_FOUR;
+
+        // 活三: 同一条线上再补一手就能得到两个成五点
+        int own_stones = 0;
+        for (int k = 0; k < ABAI_LINE_WINDOW; ++k) if (k != 4 && cells[k] == piece) ++own_stones;
+        if (own_stones < 2) return ABAI_TC_NONE;
+        for (int f = 0; f < ABAI_LINE_WINDOW; ++f) {
+            if (cells[f] != 0) continue;
+            cells[f] = piece;
+            int points = windowFivePoints(cells, piece);
+            cells[f] = 0;
+            if (points >= 2) return ABAI_TC_THREE;
+        }
+        return ABAI_TC_NONE;
+    }
+};
+
+// 进程内只构建一次，多个引擎实例与搜索线程共享
+const ThreatPatternTable& threatPatternTable() {
+    static const ThreatPatternTable table;
+    return table;
+}
+
+Point indexToPoint(int idx) {
+    Point p;
+    p.row = idx / ABAI_N;
+    p.col = idx % ABAI_N;
+    return p;
+}
+
+} // namespace
+
+// 中心两侧各 4 格的状态 (每格 2 位，超出棋盘记为墙)，作为棋型表的下标:
+// 直接取线状态中的 9 格窗口，去掉中心格的 2 位
+int AlphaBetaAI::threatWindowKey(int r, int c, int dir) const {
+    std::uint32_t window = lineWindow(dir, r * ABAI_N + c);
+    return static_cast<int>((window & 0xFF) | ((window >> (ABAI_WINDOW_CENTER_SHIFT + 2)) << 8));
+}
+
+// 在空位 (r, c) 落下 piece 后四个方向中最强的棋型；four_dirs 返回形成冲四的方向数
+int AlphaBetaAI::classifyThreat(int r, int c, int piece, int& four_dirs) const {
+    const auto& classes = threatPatternTable().classes[piece - 1];
+    int best = ABAI_TC_NONE;
+    four_dirs = 0;
+    for (int dir = 0; dir < ABAI_G_LINES; ++dir) {
+        int cls = classes[threatWindowKey(r, c, dir)];
+        if (cls == ABAI_TC_FOUR) ++four_dirs;
+        best = std::max(best, cls);
+    }
+    return best;
+}
+
+bool AlphaBetaAI::makesFive(int r, int c, int piece) const {
+    const auto& classes = threatPatternTable().classes[piece - 1];
+    for (int dir = 0; dir < ABAI_G_LINES; ++dir) {
+        if (classes[threatWindowKey(r, c, dir)] == ABAI_TC_FIVE) return true;
+    }
+    return false;
+}
+
+// 落子后是否形成对方一手挡不住的威胁: 成五、活四，或两个方向的冲四 (成五点不同)
+bool AlphaBetaAI::makesWinningThreat(int r, int c, int piece) {
+    int four_dirs;
+    int cls = classifyThreat(r, c, piece, four_dirs);
+    if (cls >= ABAI_TC_OPEN_FOUR) return true;
+    if (four_dirs < 2) return false;
+
+    // 两个方向的冲四可能共用同一个成五点，落子后逐方向核对
+    updateAIInternalState(r, c, piece);
+    int first_point = -1;
+    bool distinct = false;
+    for (int dir = 0; dir < ABAI_G_LINES && !distinct; ++dir) {
+        for (int k = -4; k <= 4 && !distinct; ++k) {
+            int rr = r + k * THREAT_DIR_DR[dir], cc = c + k * THREAT_DIR_DC[dir];
+            if (k == 0 || !isOk(rr, cc) || internal_board_bf[rr][cc] != 0) continue;
+            if (makesFive(rr, cc, piece)) {
+                int idx = rr * ABAI_N + cc;
+                if (first_point == -1) first_point = idx;
+                else if (idx != first_point) distinct = true;
+            }
+        }
+    }
+    updateAIInternalState(r, c, 0);
+    return distinct;
+}
+
+// 安静走法: 既不为自己形成活三以上的棋型，也不阻挡对方的活三以上棋型 (用于 LMR)
+bool AlphaBetaAI::isQuietMove(int r, int c, int piece) const {
+    int four_dirs;
+    return classifyThreat(r, c, piece, four_dirs) < ABAI_TC_THREE &&
+           classifyThreat(r, c, 3 - piece, four_dirs) < ABAI_TC_THREE;
+}
+
+// 棋盘上是否有一方存在成五点 (即有冲四或活四)
+bool AlphaBetaAI::hasFourOnBoard() const {
+    for (int i = 0; i < candidate_count_cc; ++i) {
+        int idx = candidate_list_cl[i];
+        if (makesFive(idx / ABAI_N, idx % ABAI_N, 1) || makesFive(idx / ABAI_N, idx % ABAI_N, 2)) return true;
+    }
+    return false;
+}
+
+// 收集 piece 的所有成五点 (成五点一定在候选集里)，返回数量
+int AlphaBetaAI::collectFivePoints(int piece, std::array<int, ABAI_N * ABAI_N>& points) const {
+    int count = 0;
+    for (int i = 0; i < candidate_count_cc; ++i) {
+        int idx = candidate_list_cl[i];
+        if (makesFive(idx / ABAI_N, idx % ABAI_N, piece)) points[count++] = idx;
+    }
+    return count;
+}
+
+// 快速路径: 不初始化内部状态，直接在外部棋盘上沿四个方向扫描 piece (外部棋子值) 的成五点
+int AlphaBetaAI::scanFivePoints(const Board& board, int piece, std::array<int, ABAI_N * ABAI_N>& points) {
+    std::array<std::array<int, ABAI_N>, ABAI_N> cells;
+    for (int r = 0; r < ABAI_N; ++r) {
+        for (int c = 0; c < ABAI_N; ++c) cells[r][c] = board.getPiece(r, c);
+    }
+    int count = 0;
+    for (int r = 0; r < ABAI_N; ++r) {
+        for (int c = 0; c < ABAI_N; ++c) {
+            if (cells[r][c] != EMPTY_PIECE) continue;
+            for (int dir = 0; dir < ABAI_G_LINES; ++dir) {
+                int run = 1;
+                for (int sign = -1; sign <= 1; sign += 2) {
+                    int rr = r + sign * THREAT_DIR_DR[dir], cc = c + sign * THREAT_DIR_DC[dir];
+                    while (rr >= 0 && rr < ABAI_N && cc >= 0 && cc < ABAI_N && cells[rr][cc] == piece) {
+                        ++run;
+                        rr += sign * THREAT_DIR_DR[dir];
+                        cc += sign * THREAT_DIR_DC[dir];
+                    }
+                }
+                if (run >= 5) {
+                    points[count++] = r * ABAI_N + c;
+                    break;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+// 己方能成五时返回成五点，否则对方有成五点时返回唯一的挡点 (有多个时任取一个，反正挡不住)
+bool AlphaBetaAI::findInstantMove(const Board& board, int playerColor, Point& move) const {
+    std::array<int, ABAI_N * ABAI_N> points;
+    const int opponentColor = playerColor == BLACK_PIECE ? WHITE_PIECE : BLACK_PIECE;
+    if (state_synced_ss) {
+        // 内部状态已同步时直接查候选集，取下标最小的点，与扫描棋盘的结果相同
+        for (int color : {playerColor, opponentColor}) {
+            int count = collectFivePoints(color == BLACK_PIECE ? 1 : 2, points);
+            if (count > 0) {
+                move = indexToPoint(*std::min_element(points.begin(), points.begin() + count));
+                return true;
+            }
+        }
+        return false;
+    }
+    if (scanFivePoints(board, playerColor, points) > 0 || scanFivePoints(board, opponentColor, points) > 0) {
+        move = indexToPoint(points[0]);
+        return true;
+    }
+    return false;
+}
+
+// 进攻方没有成五点时，生成防守方针对其活三的应对: 能同时化解所有威胁的点，以及防守方自己的冲四。
+// 结果写入 defences (至少 ABAI_N * ABAI_N 项)，数量写入 defence_count，不分配堆内存。
+// 进攻方没有一手可成活四/双四的点时返回 false (防守方可以脱先)；返回 true 且数量为 0 表示挡不住
+bool AlphaBetaAI::generateThreatDefences(int attacker, int* defences, int& defence_count) {
+    const int defender = 3 - attacker;
+    defence_count = 0;
+
+    // 找出所有能一手形成活四/双四的点
+    // makesWinningThreat 会临时落子，候选列表的顺序随之改变，先复制一份
+    const int move_count = candidate_count_cc;
+    std::array<int, ABAI_N * ABAI_N> moves;
+    std::copy(candidate_list_cl.begin(), candidate_list_cl.begin() + move_count, moves.begin());
+    std::array<int, ABAI_N * ABAI_N> threats;
+    int threat_count = 0;
+    for (int i = 0; i < move_count; ++i) {
+        if (makesWinningThreat(moves[i] / ABAI_N, moves[i] % ABAI_N, attacker)) threats[threat_count++] = moves[i];
+    }
+    if (threat_count == 0) return false;
+
+    // 能化解所有威胁的点只可能在这些威胁点所在的四条线上
+    std::array<bool, ABAI_N * ABAI_N> tried;
+    tried.fill(false);
+    for (int t = 0; t < threat_count; ++t) {
+        int threat_idx = threats[t];
+        int tr = threat_idx / ABAI_N, tc = threat_idx % ABAI_N;
+        for (int dir = 0; dir < ABAI_G_LINES; ++dir) {
+            for (int k = -4; k <= 4; ++k) {
+                int rr = tr + k * THREAT_DIR_DR[dir], cc = tc + k * THREAT_DIR_DC[dir];
+                if (!isOk(rr, cc) || internal_board_bf[rr][cc] != 0) continue;
+                int d = rr * ABAI_N + cc;
+                if (tried[d]) continue;
+                tried[d] = true;
+                updateAIInternalState(rr, cc, defender);
+                bool blocks_all = true;
+                for (int k2 = 0; k2 < threat_count; ++k2) {
+                    int other = threats[k2];
+                    if (other != d && makesWinningThreat(other / ABAI_N, other % ABAI_N, attacker)) {
+                        blocks_all = false;
+                        break;
+                    }
+                }
+                updateAIInternalState(rr, cc, 0);
+                if (blocks_all) defences[defence_count++] = d;
+            }
+        }
+    }
+    // 防守方也可以冲四抢先手 (已是化解点的不重复加入)
+    for (int i = 0; i < move_count; ++i) {
+        int idx = moves[i];
+        if (std::find(defences, defences + defence_count, idx) != defences + defence_count) continue;
+        int four_dirs;
+        if (classifyThreat(idx / ABAI_N, idx % ABAI_N, defender, four_dirs) >= ABAI_TC_FOUR) defences[defence_count++] = idx;
+    }
+    return true;
+}
+
+// 进攻方 (OR 节点) 没有成五点、也不需要挡对方时的威胁走法: 冲四在前，活三在后 (仅 allow_threes)。
+// 结果写入 moves (至少 ABAI_N * ABAI_N 项)，返回数量
+int AlphaBetaAI::generateThreatMoves(int attacker, bool allow_threes, int* moves) const {
+    std::array<int, ABAI_N * ABAI_N> threes;
+    int move_count = 0, three_count = 0;
+    for (int i = 0; i < candidate_count_cc; ++i) {
+        int idx = candidate_list_cl[i];
+        int four_dirs;
+        int cls = classifyThreat(idx / ABAI_N, idx % ABAI_N, attacker, four_dirs);
+        if (cls >= ABAI_TC_FOUR) moves[move_count++] = idx;
+        else if (allow_threes && cls == ABAI_TC_THREE) threes[three_count++] = idx;
+    }
+    std::copy(threes.begin(), threes.begin() + three_count, moves + move_count);
+    return move_count + three_count;
+}
+
+// 每个算杀节点调用一次。getMove 中还受本步时间的限制 (每 256 个节点看一次时钟)，
+// 后台思考还要听从停止信号；超时或被叫停后把节点上限置 0，本次算杀剩下的求解都立即结束
+bool AlphaBetaAI::threatBudgetExceeded() {
+    if (++threat_nodes_tn > threat_node_limit_tl) return true;
+    if (shared_stop_sp != nullptr && (threat_nodes_tn & 255) == 0 && shared_stop_sp->load(std::memory_order_relaxed)) {
+        threat_node_limit_tl = 0;
+        return true;
+    }
+    if (threat_deadline_active_td && (threat_nodes_tn & 255) == 0 && std::chrono::steady_clock::now() >= threat_deadline_dl) {
+        threat_node_limit_tl = 0;
+        return true;
+    }
+    return false;
+}
+
+// 进攻方 (OR 节点): 找到一步威胁，使防守方的所有应对都仍然输。
+// ply 为距算杀根节点的层数，成功时必胜序列写入 threat_lines_tk[ply]
+bool AlphaBetaAI::solveThreatAttack(int attacker, int depth_left, bool allow_threes, int ply) {
+    if (threatBudgetExceeded()) return false;
+    const int defender = 3 - attacker;
+    std::array<int, ABAI_N * ABAI_N> points;
+
+    // 1. 自己能成五: 直接获胜
+    if (collectFivePoints(attacker, points) > 0) {
+        threat_lines_tk[ply][0] = points[0];
+        threat_line_length_tk[ply] = 1;
+        return true;
+    }
+    if (depth_left <= 0) return false;
+
+    // 2. 对方有成五点: 只能去挡 (两个以上挡不住)
+    std::array<int, ABAI_N * ABAI_N> moves;
+    int move_count = 1;
+    int defender_fives = collectFivePoints(defender, points);
+    if (defender_fives >= 2) return false;
+    if (defender_fives == 1) {
+        moves[0] = points[0];
+    } else {
+        // 3. 生成威胁走法: 冲四在前，活三在后 (仅 VCT)
+        move_count = generateThreatMoves(attacker, allow_threes, moves.data());
+    }
+
+    for (int i = 0; i < move_count; ++i) {
+        int idx = moves[i];
+        int r = idx / ABAI_N, c = idx % ABAI_N;
+        updateAIInternalState(r, c, attacker);
+        bool win = solveThreatDefence(attacker, depth_left - 1, allow_threes, ply + 1);
+        updateAIInternalState(r, c, 0);
+        if (win) {
+            prependThreatLine(ply, idx);
+            return true;
+        }
+        if (threat_nodes_tn > threat_node_limit_tl) return false;
+    }
+    return false;
+}
+
+// 防守方 (AND 节点): 进攻方刚走完，只有所有防守都失败时才算进攻成功
+bool AlphaBetaAI::solveThreatDefence(int attacker, int depth_left, bool allow_threes, int ply) {
+    if (threatBudgetExceeded()) return false;
+    const int defender = 3 - attacker;
+    std::array<int, ABAI_N * ABAI_N> points;
+
+    // 1. 防守方自己能成五: 进攻失败
+    if (collectFivePoints(defender, points) > 0) return false;
+
+    // 2. 进攻方有成五点: 两个以上挡不住，一个则必须去挡
+    int attacker_fives = collectFivePoints(attacker, points);
+    if (attacker_fives >= 2) {
+        threat_line_length_tk[ply] = 0;
+        return true;
+    }
+    std::array<int, ABAI_N * ABAI_N> defences;
+    int defence_count = 1;
+    if (attacker_fives == 1) {
+        defences[0] = points[0];
+    } else {
+        if (!allow_threes) return false; // VCF 中不冲四就是失败
+
+        // 3. 进攻方的活三
+        if (!generateThreatDefences(attacker, defences.data(), defence_count)) return false; // 没有威胁，防守方可以脱先
+        if (defence_count == 0) { // 挡不住
+            threat_line_length_tk[ply] = 0;
+            return true;
+        }
+    }
+
+    for (int i = 0; i < defence_count; ++i) {
+        int idx = defences[i];
+        int r = idx / ABAI_N, c = idx % ABAI_N;
+        updateAIInternalState(r, c, defender);
+        bool win = solveThreatAttack(attacker, depth_left, allow_threes, ply + 1);
+        updateAIInternalState(r, c, 0);
+        if (!win) return false;
+        if (i == 0) prependThreatLine(ply, idx); // 记录第一种防守下的后续，作为主要变化 (后面的防守会覆盖下一层)
+    }
+    return true;
+}
+
+// 第 ply 层的必胜序列 = move + 第 ply+1 层的序列
+void AlphaBetaAI::prependThreatLine(int ply, int move) {
+    const int child_length = threat_line_length_tk[ply + 1];
+    threat_lines_tk[ply][0] = move;
+    std::copy(threat_lines_tk[ply + 1].begin(), threat_lines_tk[ply + 1].begin() + child_length, threat_lines_tk[ply].begin() + 1);
+    threat_line_length_tk[ply] = child_length + 1;
+}
+
+// 对方 (attacker) 有必胜时，找出我方能化解的走法，写入 defences (至少 ABAI_N * ABAI_N 项)，返回数量。
+// 所有候选共用一份节点预算，预算用完后剩下的走法都视为可能的防守点 (交给搜索判断)
+int AlphaBetaAI::findThreatDefences(int attacker, bool allow_threes, int* defences) {
+    const int defender = 3 - attacker;
+    const int max_depth = allow_threes ? ABAI_VCT_MAX_DEPTH : ABAI_VCF_MAX_DEPTH;
+    // 试走会改变候选列表的顺序，先复制一份
+    const int move_count = candidate_count_cc;
+    std::array<int, ABAI_N * ABAI_N> moves;
+    std::copy(candidate_list_cl.begin(), candidate_list_cl.begin() + move_count, moves.begin());
+    int defence_count = 0;
+    threat_nodes_tn = 0;
+    for (int i = 0; i < move_count; ++i) {
+        int idx = moves[i];
+        int r = idx / ABAI_N, c = idx % ABAI_N;
+        updateAIInternalState(r, c, defender);
+        bool still_lost = solveThreatAttack(attacker, max_depth, allow_threes, 0);
+        updateAIInternalState(r, c, 0);
+        if (!still_lost) defences[defence_count++] = idx;
+    }
+    return defence_count;
+}
+
+// 算杀顺序: 我方 VCF → 对方 VCF → 我方 VCT → 对方 VCT。
+// 结果写入 result (先清空)；列表已预留容量时不分配堆内存
+void AlphaBetaAI::runThreatSpaceSolver(int piece, ThreatSpaceResult& result) {
+    result.status = ThreatSpaceResult::Status::NONE;
+    result.by_vcf = false;
+    result.winning_line.clear();
+    result.defence_moves.clear();
+    const int opponent = 3 - piece;
+    threat_node_limit_tl = ABAI_THREAT_NODE_LIMIT;
+
+    for (int pass = 0; pass < 2; ++pass) {
+        const bool allow_threes = (pass == 1);
+        const int max_depth = allow_threes ? ABAI_VCT_MAX_DEPTH : ABAI_VCF_MAX_DEPTH;
+
+        threat_nodes_tn = 0;
+        if (solveThreatAttack(piece, max_depth, allow_threes, 0)) {
+            result.status = ThreatSpaceResult::Status::WIN;
+            result.by_vcf = !allow_threes;
+            for (int k = 0; k < threat_line_length_tk[0]; ++k) result.winning_line.push_back(indexToPoint(threat_lines_tk[0][k]));
+            return;
+        }
+
+        // 假设我方脱先，对方是否有必胜
+        threat_nodes_tn = 0;
+        if (solveThreatAttack(opponent, max_depth, allow_threes, 0)) {
+            result.by_vcf = !allow_threes;
+            for (int k = 0; k < threat_line_length_tk[0]; ++k) result.winning_line.push_back(indexToPoint(threat_lines_tk[0][k]));
+            std::array<int, ABAI_N * ABAI_N> defences;
+            const int defence_count = findThreatDefences(opponent, allow_threes, defences.data());
+            for (int i = 0; i < defence_count; ++i) result.defence_moves.push_back(indexToPoint(defences[i]));
+            result.status = defence_count == 0 ? ThreatSpaceResult::Status::LOST : ThreatSpaceResult::Status::DEFEND;
+            return;
+        }
+    }
+}
+
+// 对局通知维护的内部状态不能被 board 覆盖，否则之后的 getMove 与通知都作用在错误的局面上
+ThreatSpaceResult AlphaBetaAI::analyzeThreats(const Board& board, int playerColor) {
+    const bool restore = loadAnalysisPosition(board);
+    aiPlayerColor_op = playerColor == BLACK_PIECE ? 1 : 2;
+    ThreatSpaceResult result;
+    runThreatSpaceSolver(aiPlayerColor_op, result);
+    if (restore) restoreSyncedState();
+    return result;
+}
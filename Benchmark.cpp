@@ -0,0 +1,706 @@
+// Copyright (c) 2025 wibyuan
+// Licensed under the MIT License (see LICENSE for details)
+//
+// AI 基准测试程序 (不依赖 SDL)，通过 CMake 选项 WIBYUAN_BUILD_BENCHMARK 构建。
+// 用法:
+//   WibyuanGomoku_bench threads [最大线程数] [搜索深度]
+//       Lazy SMP 扩展性测试: 对 1..N 个线程报告每秒节点数与到达各深度的用时
+//   WibyuanGomoku_bench suite [搜索深度]
+//       固定局面集: 分别开关 PVS、渴望窗口、LMR、空着裁剪与静态搜索，比较单线程搜索到指定深度的节点数
+//   WibyuanGomoku_bench prove [节点上限]
+//       对固定局面集的每个局面运行证明数搜索 (ProofNumberAI)，报告结论、必胜走法与用时
+//   WibyuanGomoku_bench alloc [搜索深度]
+//       分别统计关闭/开启算杀时 getMove 期间的堆分配次数，都应为 0 (不为 0 时返回 1)
+//   WibyuanGomoku_bench kernel [迭代次数]
+//       批量落子增益内核: 比较标量/SSE2/AVX2 实现的用时，并检查结果与标量版本逐位相同
+//   WibyuanGomoku_bench multipv [线数] [搜索深度]
+//       多主变例分析: 一次 analyzeTopMoves 与逐条排除前面走法、各自独立搜索的用时与节点数对比
+//   WibyuanGomoku_bench ponder [对手思考毫秒] [搜索深度]
+//       后台思考: 从固定局面对弈若干步，比较开/关后台思考时 AI 每步的响应时间与猜中次数
+//   WibyuanGomoku_bench stats [搜索深度]
+//       打印每个局面的 SearchStatistics (详细字段需要以 ABAI_SEARCH_STATS=1 编译)
+//   WibyuanGomoku_bench trace [追踪文件] [搜索深度]
+//       把固定局面集的搜索树写入追踪文件 (用 WibyuanGomoku_trace_summary 分析)，并比较开/关追踪的用时
+//   WibyuanGomoku_bench persist [置换表文件] [搜索深度]
+//       持久置换表: 每个局面先用新建的文件搜索一次，再用新的引擎实例重新打开同一文件搜索 (模拟进程重启)
+//   WibyuanGomoku_bench levels [每局面步数]
+//       难度阶梯: 每一级从固定局面自我对弈若干步，报告每步的最长/平均用时与节点数是否守住该级的上限
+//   WibyuanGomoku_bench eval [搜索深度] [每步节点数]
+//       评估函数对比: 窗口计分与棋型评估各自搜索到指定深度的节点数与用时，再从每个局面交换先后手对弈，统计胜负
+#include "AlphaBetaAI.h"
+#include "ProofNumberAI.h"
+#include "PatternKernel.h"
+#include "Board.h"
+#include "Constants.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <atomic>
+#include <cstdio>
+#include <algorithm>
+
+// 统计全局 operator new 的调用次数，用于 alloc 模式
+static std::atomic<long long> g_allocation_count(0);
+
+// 替换后的 new/delete 以 malloc/free 实现，是配对的。GCC 在 -O2 下把替换版内联后会看到 free
+// 释放"operator new 返回的指针"，误报 -Wmismatched-new-delete，这里只对这几个定义关闭该警告
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size > 0 ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+// 测试局面: 从黑棋开始交替落子的走法序列
+struct BenchPosition {
+    const char* name;
+    std::vector<Point> moves;
+};
+
+const std::vector<BenchPosition>& benchPositions() {
+    static const std::vector<BenchPosition> positions = {
+        {"开局-13子", {{7,7},{6,8},{8,8},{6,6},{5,7},{6,7},{6,5},{7,6},{5,6},{5,8},{8,5},{3,8},{4,8}}},
+        {"中局-14子", {{7,7},{7,8},{8,7},{6,7},{5,6},{8,8},{9,8},{7,6},{5,8},{5,7},{4,7},{7,10},{7,9},{6,5}}},
+        {"中局-10子", {{7,7},{8,8},{8,6},{9,7},{8,7},{8,5},{7,6},{9,6},{9,8},{10,9}}},
+    };
+    return positions;
+}
+
+// 根据走法序列摆出局面，返回轮到下棋的一方
+int setupPosition(const BenchPosition& position, Board& board) {
+    board.reset();
+    int color = BLACK_PIECE;
+    for (const Point& move : position.moves) {
+        board.placePiece(move.row, move.col, color);
+        color = (color == BLACK_PIECE) ? WHITE_PIECE : BLACK_PIECE;
+    }
+    return color;
+}
+
+// 搜索期间屏蔽 AI 的调试输出
+class CoutSilencer {
+public:
+    CoutSilencer() : saved(std::cout.rdbuf(nullptr)) {}
+    ~CoutSilencer() { std::cout.rdbuf(saved); }
+private:
+    std::streambuf* saved;
+};
+
+int runThreadScaling(int max_threads, int depth) {
+    std::cout << "Lazy SMP 扩展性测试: 深度 " << depth << ", 线程 1.." << max_threads << std::endl;
+    for (int threads = 1; threads <= max_threads; ++threads) {
+        long long total_nodes = 0;
+        double total_ms = 0.0;
+        double cutoff_rate_sum = 0.0;
+        std::vector<long long> depth_ms_sum(depth + 1, 0);
+        for (const BenchPosition& position : benchPositions()) {
+            Board board;
+            int color = setupPosition(position, board);
+            std::unique_ptr<AlphaBetaAI> engine;
+            {
+                CoutSilencer silencer;
+                engine = std::make_unique<AlphaBetaAI>(depth, 30);
+                engine->setThreadCount(threads);
+                engine->setSearchLimits(0, 0); // 不限时间，搜索到指定深度
+            }
+            auto start = std::chrono::steady_clock::now();
+            {
+                CoutSilencer silencer;
+                engine->getMove(board, color);
+            }
+            total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            total_nodes += engine->getLastSearchNodes();
+            cutoff_rate_sum += engine->getLastFirstMoveCutoffRate();
+            for (int d = 1; d <= depth; ++d) {
+                long long ms = engine->getLastDepthTimeMs(d);
+                if (ms >= 0) depth_ms_sum[d] += ms;
+            }
+        }
+        std::cout << "线程=" << std::setw(2) << threads
+                  << "  节点=" << std::setw(10) << total_nodes
+                  << "  用时=" << std::setw(8) << std::fixed << std::setprecision(1) << total_ms << "ms"
+                  << "  节点/秒=" << std::setw(10) << static_cast<long long>(total_nodes * 1000.0 / (total_ms > 0 ? total_ms : 1))
+                  << "  首着剪枝率=" << std::setprecision(1) << cutoff_rate_sum * 100.0 / benchPositions().size() << "%"
+                  << "  到达深度用时(ms):";
+        for (int d = 1; d <= depth; ++d) std::cout << " d" << d << "=" << depth_ms_sum[d];
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
+int runSearchSuite(int depth) {
+    struct SuiteConfig {
+        const char* name;
+        bool use_pvs;
+        int aspiration_window;
+        bool use_lmr;
+        bool use_null_move;
+        bool use_quiescence;
+    };
+    const SuiteConfig configs[] = {
+        {"完整窗口", false, 0, false, false, false},
+        {"PVS", true, 0, false, false, false},
+        {"渴望窗口", false, ABAI_ASPIRATION_WINDOW, false, false, false},
+        {"PVS+渴望窗口", true, ABAI_ASPIRATION_WINDOW, false, false, false},
+        {"+LMR", true, ABAI_ASPIRATION_WINDOW, true, false, false},
+        {"+LMR+空着", true, ABAI_ASPIRATION_WINDOW, true, true, false},
+        {"+静态搜索", true, ABAI_ASPIRATION_WINDOW, true, true, true},
+    };
+    std::cout << "固定局面集: 深度 " << depth << ", 局面数 " << benchPositions().size() << std::endl;
+    for (const SuiteConfig& config : configs) {
+        long long total_nodes = 0, pvs_researches = 0, aspiration_researches = 0;
+        long long lmr_count = 0, lmr_researches = 0, null_cutoffs = 0, null_verified = 0;
+        double total_ms = 0.0;
+        for (const BenchPosition& position : benchPositions()) {
+            Board board;
+            int color = setupPosition(position, board);
+            std::unique_ptr<AlphaBetaAI> engine;
+            {
+                CoutSilencer silencer;
+                engine = std::make_unique<AlphaBetaAI>(depth, 30);
+                engine->setSearchLimits(0, 0);
+                engine->setPrincipalVariationSearch(config.use_pvs);
+                engine->setAspirationWindow(config.aspiration_window);
+                engine->setLateMoveReductions(config.use_lmr);
+                engine->setNullMovePruning(config.use_null_move);
+                engine->setQuiescenceSearch(config.use_quiescence);
+            }
+            auto start = std::chrono::steady_clock::now();
+            {
+                CoutSilencer silencer;
+                engine->getMove(board, color);
+            }
+            total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            total_nodes += engine->getLastSearchNodes();
+            pvs_researches += engine->getLastPVSResearchCount();
+            aspiration_researches += engine->getLastAspirationResearchCount();
+            lmr_count += engine->getLastLMRCount();
+            lmr_researches += engine->getLastLMRResearchCount();
+            null_cutoffs += engine->getLastNullMoveCutoffCount();
+            null_verified += engine->getLastNullMoveVerifiedCount();
+        }
+        std::cout << std::left << std::setw(16) << config.name << std::right
+                  << "  节点=" << std::setw(10) << total_nodes
+                  << "  用时=" << std::setw(8) << std::fixed << std::setprecision(1) << total_ms << "ms"
+                  << "  PVS重搜=" << pvs_researches
+                  << "  渴望窗口重搜=" << aspiration_researches
+                  << "  LMR=" << lmr_count << "/" << lmr_researches
+                  << "  空着=" << null_cutoffs << "/" << null_verified << std::endl;
+    }
+    return 0;
+}
+
+int runProofSuite(long long node_limit) {
+    std::cout << "证明数搜索: 节点上限 " << node_limit << std::endl;
+    std::unique_ptr<ProofNumberAI> solver;
+    {
+        CoutSilencer silencer;
+        solver = std::make_unique<ProofNumberAI>(PNAI_DEFAULT_TABLE_SIZE_MB, node_limit);
+    }
+    const char* status_names[] = {"必胜", "无必胜", "未知"};
+    for (const BenchPosition& position : benchPositions()) {
+        Board board;
+        int color = setupPosition(position, board);
+        ProofNumberResult result;
+        auto start = std::chrono::steady_clock::now();
+        {
+            CoutSilencer silencer;
+            result = solver->solve(board, color);
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << position.name << "  结论=" << status_names[static_cast<int>(result.status)]
+                  << "  走法=(" << result.winning_move.row << "," << result.winning_move.col << ")"
+                  << "  节点=" << result.nodes << "  用时=" << std::fixed << std::setprecision(1) << ms << "ms" << std::endl;
+    }
+    return 0;
+}
+
+int runAllocationCheck(int depth) {
+    std::cout << "堆分配统计: 深度 " << depth << std::endl;
+    int failures = 0;
+    for (const BenchPosition& position : benchPositions()) {
+        Board board;
+        int color = setupPosition(position, board);
+        long long allocations[2] = {0, 0}; // [关闭算杀, 开启算杀]
+        long long nodes = 0;
+        for (int threat_solver = 0; threat_solver <= 1; ++threat_solver) {
+            std::unique_ptr<AlphaBetaAI> engine;
+            {
+                CoutSilencer silencer;
+                engine = std::make_unique<AlphaBetaAI>(depth, 30);
+                engine->setSearchLimits(0, 0);
+                engine->setThreatSolver(threat_solver != 0);
+            }
+            long long before = g_allocation_count.load();
+            {
+                CoutSilencer silencer;
+                engine->getMove(board, color);
+            }
+            allocations[threat_solver] = g_allocation_count.load() - before;
+            if (threat_solver == 0) nodes = engine->getLastSearchNodes();
+        }
+        if (allocations[0] != 0 || allocations[1] != 0) ++failures;
+        std::cout << position.name << "  节点=" << nodes << "  分配次数=" << allocations[0]
+                  << "  开启算杀后分配次数=" << allocations[1] << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+volatile int g_kernel_sink = 0;
+
+int runKernelBenchmark(int iterations) {
+    const PatternKernelPath paths[] = {PatternKernelPath::SCALAR, PatternKernelPath::SSE2, PatternKernelPath::AVX2};
+    const std::array<int, PK_WEIGHTS_SIZE> weights = {0, 1, 3, 9, 27, 10000000};
+    std::cout << "批量落子增益内核: 每个局面 " << iterations << " 次, 本机最优实现 "
+              << patternKernelPathName(bestPatternKernelPath()) << std::endl;
+    for (const BenchPosition& position : benchPositions()) {
+        Board board;
+        setupPosition(position, board);
+        std::array<std::array<int, PK_N>, PK_N> cells;
+        for (int r = 0; r < PK_N; ++r) {
+            for (int c = 0; c < PK_N; ++c) cells[r][c] = board.getPiece(r, c);
+        }
+        std::unique_ptr<PlacementGains> reference = std::make_unique<PlacementGains>();
+        std::unique_ptr<PlacementGains> gains = std::make_unique<PlacementGains>();
+        computePlacementGains(cells, weights, 3, *reference, PatternKernelPath::SCALAR);
+        double scalar_ns = 0.0;
+        std::cout << position.name;
+        for (PatternKernelPath path : paths) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                computePlacementGains(cells, weights, 3, *gains, path);
+                g_kernel_sink = gains->black[0][(i % PK_N) * PK_GAIN_STRIDE + i % PK_N]; // 防止循环被优化掉
+            }
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+            if (path == PatternKernelPath::SCALAR) scalar_ns = ns;
+            bool identical = true;
+            for (int dir = 0; dir < PK_LINES; ++dir) {
+                for (int r = 0; r < PK_N; ++r) {
+                    for (int c = 0; c < PK_N; ++c) {
+                        int idx = r * PK_GAIN_STRIDE + c;
+                        identical = identical && gains->black[dir][idx] == reference->black[dir][idx]
+                                              && gains->white[dir][idx] == reference->white[dir][idx];
+                    }
+                }
+            }
+            std::cout << "  " << patternKernelPathName(path) << "=" << std::fixed << std::setprecision(0) << ns << "ns"
+                      << " (x" << std::setprecision(2) << scalar_ns / ns << (identical ? "" : ", 结果不一致!") << ")";
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
+// 各条线的走法与分数，例如 (7,8)=120 (6,9)=96
+std::string formatLines(const std::vector<MultiPVLine>& lines) {
+    std::string text;
+    for (const MultiPVLine& line : lines) {
+        text += " (" + std::to_string(line.move.row) + "," + std::to_string(line.move.col) + ")=" + std::to_string(line.score);
+    }
+    return text;
+}
+
+int runMultiPVBenchmark(int line_count, int depth) {
+    std::cout << "多主变例分析: " << line_count << " 条线, 深度 " << depth << std::endl;
+    for (const BenchPosition& position : benchPositions()) {
+        Board board;
+        int color = setupPosition(position, board);
+
+        // 共享: 一次搜索得到全部的线
+        std::unique_ptr<AlphaBetaAI> engine;
+        std::vector<MultiPVLine> shared_lines;
+        auto start = std::chrono::steady_clock::now();
+        {
+            CoutSilencer silencer;
+            engine = std::make_unique<AlphaBetaAI>(depth, 30);
+            engine->setSearchLimits(0, 0);
+            shared_lines = engine->analyzeTopMoves(board, color, line_count);
+        }
+        double shared_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        long long shared_nodes = engine->getLastSearchNodes();
+
+        // 基准: 每条线用一个新引擎单独搜索，排除前面各条线的走法
+        std::vector<MultiPVLine> separate_lines;
+        std::vector<Point> excluded;
+        long long separate_nodes = 0;
+        start = std::chrono::steady_clock::now();
+        for (int line = 0; line < line_count; ++line) {
+            std::vector<MultiPVLine> result;
+            {
+                CoutSilencer silencer;
+                engine = std::make_unique<AlphaBetaAI>(depth, 30);
+                engine->setSearchLimits(0, 0);
+                result = engine->analyzeTopMoves(board, color, 1, excluded);
+            }
+            separate_nodes += engine->getLastSearchNodes();
+            if (result.empty()) break;
+            separate_lines.push_back(result[0]);
+            excluded.push_back(result[0].move);
+        }
+        double separate_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << position.name << std::fixed << std::setprecision(1)
+                  << "  共享: 节点=" << shared_nodes << " 用时=" << shared_ms << "ms"
+                  << "  逐条: 节点=" << separate_nodes << " 用时=" << separate_ms << "ms"
+                  << "  (x" << std::setprecision(2) << separate_ms / (shared_ms > 0 ? shared_ms : 1) << ")" << std::endl;
+        std::cout << "  共享:" << formatLines(shared_lines) << std::endl;
+        std::cout << "  逐条:" << formatLines(separate_lines) << std::endl;
+    }
+    return 0;
+}
+
+// 从局面开始让 engine 与另一个引擎 (模拟人类，每步额外思考 think_ms) 对弈 move_count 步，
+// 返回 engine 每步 getMove 的平均用时 (毫秒)
+double playPonderGame(const BenchPosition& position, int think_ms, int depth, int move_count, bool ponder,
+                      long long& hits, long long& misses) {
+    // 后台线程随时会输出调试信息，整局都屏蔽
+    CoutSilencer silencer;
+    Board board;
+    int color = setupPosition(position, board);
+    auto engine = std::make_unique<AlphaBetaAI>(depth, 30);
+    auto opponent = std::make_unique<AlphaBetaAI>(depth, 30);
+    engine->setSearchLimits(0, 0);
+    opponent->setSearchLimits(0, 0);
+    engine->setPondering(ponder);
+    engine->onNewGame();
+    int replay_color = BLACK_PIECE;
+    for (const Point& move : position.moves) {
+        engine->onMovePlayed(move.row, move.col, replay_color);
+        replay_color = (replay_color == BLACK_PIECE) ? WHITE_PIECE : BLACK_PIECE;
+    }
+    const int opponent_color = (color == BLACK_PIECE) ? WHITE_PIECE : BLACK_PIECE;
+    double total_ms = 0.0;
+    int moves_played = 0;
+    for (int i = 0; i < move_count; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        Point move = engine->getMove(board, color);
+        total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        ++moves_played;
+        if (!board.placePiece(move.row, move.col, color)) break;
+        engine->onMovePlayed(move.row, move.col, color);
+        if (board.checkWin(move.row, move.col, color) || board.isFull()) break;
+
+        // 对手先定好应手再开始后台思考，避免单核机器上两者争抢 CPU；之后的 think_ms 模拟人类思考
+        Point reply = opponent->getMove(board, opponent_color);
+        engine->startPondering(board, color);
+        std::this_thread::sleep_for(std::chrono::milliseconds(think_ms));
+        if (!board.placePiece(reply.row, reply.col, opponent_color)) break;
+        engine->onMovePlayed(reply.row, reply.col, opponent_color);
+        if (board.checkWin(reply.row, reply.col, opponent_color) || board.isFull()) break;
+    }
+    engine->stopPondering();
+    hits += engine->getPonderHitCount();
+    misses += engine->getPonderMissCount();
+    return total_ms / (moves_played > 0 ? moves_played : 1);
+}
+
+int runPonderBenchmark(int think_ms, int depth) {
+    const int move_count = 6;
+    std::cout << "后台思考: 对手每步思考 " << think_ms << "ms, 深度 " << depth << ", 每局 " << move_count << " 步" << std::endl;
+    for (const BenchPosition& position : benchPositions()) {
+        long long hits = 0, misses = 0, unused_hits = 0, unused_misses = 0;
+        double off_ms = playPonderGame(position, think_ms, depth, move_count, false, unused_hits, unused_misses);
+        double on_ms = playPonderGame(position, think_ms, depth, move_count, true, hits, misses);
+        std::cout << position.name << std::fixed << std::setprecision(1)
+                  << "  关闭: 平均响应=" << off_ms << "ms"
+                  << "  开启: 平均响应=" << on_ms << "ms"
+                  << "  猜中=" << hits << " 未猜中=" << misses << std::endl;
+    }
+    return 0;
+}
+
+int runStatisticsReport(int depth) {
+    std::cout << "搜索统计: 深度 " << depth << (ABAI_SEARCH_STATS ? "" : " (未启用 ABAI_SEARCH_STATS，无详细字段)") << std::endl;
+    for (const BenchPosition& position : benchPositions()) {
+        Board board;
+        int color = setupPosition(position, board);
+        SearchStatistics stats;
+        {
+            CoutSilencer silencer;
+            AlphaBetaAI engine(depth, 30);
+            engine.setSearchLimits(0, 0);
+            engine.getMove(board, color, stats);
+        }
+        std::cout << position.name << "  节点=" << stats.nodes << "  用时=" << stats.elapsed_ms << "ms"
+                  << "  节点/秒=" << static_cast<long long>(stats.nodes_per_second)
+                  << "  剪枝节点=" << stats.cutoff_nodes << "  置换表命中=" << stats.tt_hits << "/" << stats.tt_probes << std::endl;
+        std::cout << "  深度  节点      用时(ms)  分支因子" << std::endl;
+        for (int d = 1; d <= stats.completed_depth; ++d) {
+            std::cout << "  " << std::setw(4) << d << "  " << std::setw(8) << stats.depth_nodes[d]
+                      << "  " << std::setw(8) << stats.depth_time_ms[d] << "  " << std::fixed << std::setprecision(2)
+                      << stats.branching_factor[d] << std::endl;
+        }
+        if (stats.detailed) {
+            std::cout << "  评估更新=" << stats.evaluation_updates << "  按走法序号的剪枝:";
+            for (int i = 0; i < ABAI_STATS_CUTOFF_SLOTS; ++i) {
+                std::cout << " " << (i + 1) << (i + 1 == ABAI_STATS_CUTOFF_SLOTS ? "+" : "") << "=" << stats.cutoffs_by_move_index[i];
+            }
+            std::cout << std::endl;
+        }
+    }
+    return 0;
+}
+
+// 搜索一次并返回用时 (毫秒)，每次都先清空置换表，开/关追踪的两次搜索完全相同
+double timedSearch(AlphaBetaAI& engine, const Board& board, int color) {
+    CoutSilencer silencer;
+    engine.setTranspositionTableSize(ABAI_TT_DEFAULT_SIZE_MB);
+    auto start = std::chrono::steady_clock::now();
+    engine.getMove(board, color);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int runTraceBenchmark(const std::string& path, int depth) {
+    std::cout << "搜索追踪: 文件 " << path << ", 深度 " << depth << std::endl;
+    std::unique_ptr<AlphaBetaAI> plain, traced;
+    {
+        CoutSilencer silencer;
+        plain = std::make_unique<AlphaBetaAI>(depth, 30);
+        traced = std::make_unique<AlphaBetaAI>(depth, 30);
+        plain->setSearchLimits(0, 0);
+        traced->setSearchLimits(0, 0);
+        if (!traced->setSearchTrace(path)) return 1;
+    }
+    for (const BenchPosition& position : benchPositions()) { // 所有局面写入同一个追踪文件
+        Board board;
+        int color = setupPosition(position, board);
+        double plain_ms = timedSearch(*plain, board, color);
+        double traced_ms = timedSearch(*traced, board, color);
+        std::cout << position.name << "  节点=" << traced->getLastSearchNodes() << std::fixed << std::setprecision(1)
+                  << "  不追踪=" << plain_ms << "ms  追踪=" << traced_ms << "ms" << std::endl;
+    }
+    traced.reset(); // 关闭文件
+    return 0;
+}
+
+// 用映射到 path 的置换表搜索一次，返回用时 (毫秒)
+double searchWithPersistentTable(const BenchPosition& position, const std::string& path, int depth,
+                                 long long& nodes, Point& move) {
+    Board board;
+    int color = setupPosition(position, board);
+    CoutSilencer silencer;
+    AlphaBetaAI engine(depth, 30);
+    engine.setSearchLimits(0, 0);
+    if (!engine.openPersistentTranspositionTable(path)) return -1.0;
+    auto start = std::chrono::steady_clock::now();
+    move = engine.getMove(board, color);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    nodes = engine.getLastSearchNodes();
+    return ms;
+}
+
+int runPersistentTableBenchmark(const std::string& path, int depth) {
+    std::cout << "持久置换表: 文件 " << path << ", 深度 " << depth << std::endl;
+    for (const BenchPosition& position : benchPositions()) {
+        std::remove(path.c_str());
+        long long cold_nodes = 0, warm_nodes = 0;
+        Point cold_move, warm_move;
+        double cold_ms = searchWithPersistentTable(position, path, depth, cold_nodes, cold_move);
+        double warm_ms = searchWithPersistentTable(position, path, depth, warm_nodes, warm_move);
+        if (cold_ms < 0 || warm_ms < 0) {
+            std::cerr << "无法打开置换表文件: " << path << std::endl;
+            return 1;
+        }
+        std::cout << position.name << std::fixed << std::setprecision(1)
+                  << "  新建: 节点=" << cold_nodes << " 用时=" << cold_ms << "ms"
+                  << "  重新打开: 节点=" << warm_nodes << " 用时=" << warm_ms << "ms"
+                  << "  走法" << (cold_move.row == warm_move.row && cold_move.col == warm_move.col ? "一致" : "不同") << std::endl;
+    }
+    std::remove(path.c_str());
+    return 0;
+}
+
+int runDifficultyLevels(int moves_per_position) {
+    std::cout << "难度阶梯: 每个局面自我对弈 " << moves_per_position << " 步" << std::endl;
+    int violations = 0;
+    for (int level = 0; level < ABAI_DIFFICULTY_LEVEL_COUNT; ++level) {
+        const ABAIDifficultyLevel& config = ABAI_DIFFICULTY_LEVELS[level];
+        double max_ms = 0.0, total_ms = 0.0;
+        long long max_nodes = 0, total_nodes = 0;
+        int move_count = 0;
+        for (const BenchPosition& position : benchPositions()) {
+            Board board;
+            int color = setupPosition(position, board);
+            CoutSilencer silencer;
+            AlphaBetaAI engine;
+            engine.setDifficultyLevel(level);
+            for (int i = 0; i < moves_per_position; ++i) {
+                auto start = std::chrono::steady_clock::now();
+                Point move = engine.getMove(board, color);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                if (move.row < 0 || !board.placePiece(move.row, move.col, color)) break;
+                max_ms = std::max(max_ms, ms);
+                total_ms += ms;
+                max_nodes = std::max(max_nodes, engine.getLastSearchNodes());
+                total_nodes += engine.getLastSearchNodes();
+                ++move_count;
+                if (board.checkWin(move.row, move.col, color)) break;
+                color = (color == BLACK_PIECE) ? WHITE_PIECE : BLACK_PIECE;
+            }
+        }
+        // 时限在深度 1 也生效；时钟每 1024 个节点才看一次，加上返回与收尾的开销，只允许 2% (至少 5ms) 的余量
+        const bool within = max_ms <= config.time_limit_ms + std::max(5.0, config.time_limit_ms * 0.02);
+        if (!within) ++violations;
+        std::cout << config.name << std::fixed << std::setprecision(1)
+                  << "  上限: " << config.time_limit_ms << "ms/" << config.node_limit << "节点"
+                  << "  最长=" << max_ms << "ms 平均=" << (move_count > 0 ? total_ms / move_count : 0.0) << "ms"
+                  << "  节点: 最多=" << max_nodes << " 平均=" << (move_count > 0 ? total_nodes / move_count : 0)
+                  << (within ? "" : "  [超时]") << std::endl;
+    }
+    return violations == 0 ? 0 : 1;
+}
+
+const char* evaluatorName(ABAIEvaluator evaluator) {
+    return evaluator == ABAIEvaluator::LINE_PATTERNS ? "棋型评估" : "窗口计分";
+}
+
+// 从 position 开始对弈，轮到的一方用 first 评估，另一方用 second 评估。
+// 返回 1 表示 first 胜，-1 表示 second 胜，0 表示和棋 (走满 max_moves 步或棋盘下满)
+int playEvaluatorGame(const BenchPosition& position, ABAIEvaluator first, ABAIEvaluator second,
+                      int depth, long long node_limit, int max_moves) {
+    Board board;
+    int color = setupPosition(position, board);
+    CoutSilencer silencer;
+    std::unique_ptr<AlphaBetaAI> engines[2];
+    for (int i = 0; i < 2; ++i) {
+        engines[i] = std::make_unique<AlphaBetaAI>(depth, 30);
+        engines[i]->setEvaluator(i == 0 ? first : second);
+        engines[i]->setSearchLimits(0, node_limit);
+    }
+    const int first_color = color;
+    for (int i = 0; i < max_moves; ++i) {
+        AlphaBetaAI& engine = *engines[color == first_color ? 0 : 1];
+        Point move = engine.getMove(board, color);
+        if (move.row < 0 || !board.placePiece(move.row, move.col, color)) return 0;
+        if (board.checkWin(move.row, move.col, color)) return color == first_color ? 1 : -1;
+        color = (color == BLACK_PIECE) ? WHITE_PIECE : BLACK_PIECE;
+    }
+    return 0;
+}
+
+int runEvaluatorComparison(int depth, long long node_limit) {
+    const ABAIEvaluator evaluators[2] = {ABAIEvaluator::SHAPE_WINDOWS, ABAIEvaluator::LINE_PATTERNS};
+    std::cout << "评估函数对比: 深度 " << depth << std::endl;
+    for (const BenchPosition& position : benchPositions()) {
+        std::cout << position.name;
+        for (ABAIEvaluator evaluator : evaluators) {
+            Board board;
+            int color = setupPosition(position, board);
+            long long nodes;
+            double ms;
+            Point move;
+            {
+                CoutSilencer silencer;
+                AlphaBetaAI engine(depth, 30);
+                engine.setEvaluator(evaluator);
+                engine.setSearchLimits(0, 0);
+                auto start = std::chrono::steady_clock::now();
+                move = engine.getMove(board, color);
+                ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                nodes = engine.getLastSearchNodes();
+            }
+            std::cout << "  " << evaluatorName(evaluator) << ": 节点=" << nodes << std::fixed << std::setprecision(1)
+                      << " 用时=" << ms << "ms 节点/毫秒=" << (ms > 0 ? nodes / ms : 0.0)
+                      << " 走法=(" << move.row << "," << move.col << ")";
+        }
+        std::cout << std::endl;
+    }
+
+    // 对弈: 每个局面两种评估各先走一次，每步限定相同的节点数
+    const int max_moves = 60;
+    int wins = 0, losses = 0, draws = 0;
+    std::cout << "对弈: 每步 " << node_limit << " 节点，最多 " << max_moves << " 步 (结果为棋型评估视角)" << std::endl;
+    for (const BenchPosition& position : benchPositions()) {
+        for (int swap = 0; swap < 2; ++swap) {
+            int result = playEvaluatorGame(position, evaluators[1 - swap], evaluators[swap], depth, node_limit, max_moves);
+            if (swap == 1) result = -result; // 换成棋型评估视角
+            if (result > 0) ++wins; else if (result < 0) ++losses; else ++draws;
+            std::cout << position.name << "  棋型评估" << (swap == 0 ? "先走" : "后走") << ": "
+                      << (result > 0 ? "胜" : (result < 0 ? "负" : "和")) << std::endl;
+        }
+    }
+    std::cout << "棋型评估 胜=" << wins << " 负=" << losses << " 和=" << draws << std::endl;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string mode = argc > 1 ? argv[1] : "threads";
+    if (mode == "threads") {
+        int hw_threads = static_cast<int>(std::thread::hardware_concurrency());
+        int max_threads = argc > 2 ? std::atoi(argv[2]) : (hw_threads > 0 ? hw_threads : 4);
+        int depth = argc > 3 ? std::atoi(argv[3]) : 5;
+        return runThreadScaling(max_threads, depth);
+    }
+    if (mode == "prove") {
+        long long node_limit = argc > 2 ? std::atoll(argv[2]) : PNAI_DEFAULT_NODE_LIMIT;
+        return runProofSuite(node_limit);
+    }
+    if (mode == "suite") {
+        int depth = argc > 2 ? std::atoi(argv[2]) : 6;
+        return runSearchSuite(depth);
+    }
+    if (mode == "alloc") {
+        int depth = argc > 2 ? std::atoi(argv[2]) : 6;
+        return runAllocationCheck(depth);
+    }
+    if (mode == "kernel") {
+        int iterations = argc > 2 ? std::atoi(argv[2]) : 20000;
+        return runKernelBenchmark(iterations);
+    }
+    if (mode == "multipv") {
+        int line_count = argc > 2 ? std::atoi(argv[2]) : 4;
+        int depth = argc > 3 ? std::atoi(argv[3]) : 6;
+        return runMultiPVBenchmark(line_count, depth);
+    }
+    if (mode == "ponder") {
+        int think_ms = argc > 2 ? std::atoi(argv[2]) : 1000;
+        int depth = argc > 3 ? std::atoi(argv[3]) : 6;
+        return runPonderBenchmark(think_ms, depth);
+    }
+    if (mode == "stats") {
+        int depth = argc > 2 ? std::atoi(argv[2]) : 7;
+        return runStatisticsReport(depth);
+    }
+    if (mode == "trace") {
+        std::string path = argc > 2 ? argv[2] : "bench_trace.bin";
+        int depth = argc > 3 ? std::atoi(argv[3]) : 7;
+        return runTraceBenchmark(path, depth);
+    }
+    if (mode == "persist") {
+        std::string path = argc > 2 ? argv[2] : "bench_tt.bin";
+        int depth = argc > 3 ? std::atoi(argv[3]) : 7;
+        return runPersistentTableBenchmark(path, depth);
+    }
+    if (mode == "levels") {
+        int moves_per_position = argc > 2 ? std::atoi(argv[2]) : 6;
+        return runDifficultyLevels(moves_per_position);
+    }
+    if (mode == "eval") {
+        int depth = argc > 2 ? std::atoi(argv[2]) : 6;
+        long long node_limit = argc > 3 ? std::atoll(argv[3]) : 20000;
+        return runEvaluatorComparison(depth, node_limit);
+    }
+    std::cerr << "未知模式: " << mode << std::endl;
+    return 1;
+}
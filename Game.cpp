@@ -21,8 +21,12 @@ std::unique_ptr<Player> Game::createPlayer(AIDifficulty type) {
             std::cout << "[调试] 正在创建简单AI玩家 (GreedyAI)。" << std::endl;
             return std::make_unique<GreedyAI>();
         case AIDifficulty::ALPHA_BETA:
+        {
             std::cout << "[调试] 正在创建困难AI玩家 (AlphaBetaAI)。" << std::endl;
-            return std::make_unique<AlphaBetaAI>();
+            auto ai = std::make_unique<AlphaBetaAI>();
+            ai->setDifficultyLevel(alphaBetaLevel);
+            return ai;
+        }
         case AIDifficulty::HUMAN:
         default:
              std::cout << "[调试] 设置玩家为人类 (返回 nullptr)。" << std::endl;
@@ -42,6 +46,7 @@ Game::Game() :
     currentState(GameState::MENU),
     isFullscreen(false),
     lastPlayedMove({-1, -1}), // 初始化 lastPlayedMove
+    alphaBetaLevel(ABAI_DEFAULT_DIFFICULTY_LEVEL),
     isDraggingAboutBox(false),
     aboutTextScrollOffsetY(0),
     totalAboutTextHeight(0),
@@ -78,7 +83,7 @@ void Game::initializeMenuButtons() {
     const int buttonWidth = 350; 
     const int buttonHeight = 45; 
     const int buttonSpacing = 15; 
-    int totalButtonHeight = 8 * buttonHeight + 6 * buttonSpacing;
+    int totalButtonHeight = 9 * buttonHeight + 7 * buttonSpacing;
     int startY = (SCREEN_HEIGHT - totalButtonHeight) / 2;
     // if (startY < BORDER_PADDING * 3) startY = BORDER_PADDING * 3; 
     int currentY = startY;
@@ -96,6 +101,8 @@ void Game::initializeMenuButtons() {
     currentY += buttonHeight + buttonSpacing;
     menuButtons[MainMenuOption::HUMAN_AS_WHITE_VS_ALPHABETA] = { static_cast<float>(centerX - buttonWidth / 2), static_cast<float>(currentY), static_cast<float>(buttonWidth), static_cast<float>(buttonHeight) };
     currentY += buttonHeight + buttonSpacing;
+    menuButtons[MainMenuOption::SELECT_AI_LEVEL] = { static_cast<float>(centerX - buttonWidth / 2), static_cast<float>(currentY), static_cast<float>(buttonWidth), static_cast<float>(buttonHeight) };
+    currentY += buttonHeight + buttonSpacing;
     menuButtons[MainMenuOption::SHOW_ABOUT] = { static_cast<float>(centerX - buttonWidth / 2), static_cast<float>(currentY), static_cast<float>(buttonWidth), static_cast<float>(buttonHeight) };
     currentY += buttonHeight + buttonSpacing;
     menuButtons[MainMenuOption::SHOW_TASK_LOG] = { static_cast<float>(centerX - buttonWidth / 2), static_cast<float>(currentY), static_cast<float>(buttonWidth), static_cast<float>(buttonHeight) };
@@ -197,6 +204,11 @@ void Game::initializeTaskLogScreen() {
     totalTaskLogTextHeight = 0;
 
     taskLogTextLines.clear();
+    taskLogTextLines.push_back("版本 1.2:");
+    taskLogTextLines.push_back("新增: 困难AI分为五个难度等级，在主菜单");
+    taskLogTextLines.push_back("点击切换。每一级限定搜索节点数与每步");
+    taskLogTextLines.push_back("最长思考时间。");
+    taskLogTextLines.push_back(" ");
     taskLogTextLines.push_back("版本 1.1451 (2025-05-17):"); 
     taskLogTextLines.push_back("新增: 最新落子红色边框高亮显示功能。");
     taskLogTextLines.push_back("修复: 修复了终局的 UI 颜色显示问题。");
@@ -326,6 +338,10 @@ void Game::handleMenuEvents(const SDL_Event& event) {
                             startNewGame(AIDifficulty::HUMAN, AIDifficulty::ALPHA_BETA); break;
                         case MainMenuOption::HUMAN_AS_WHITE_VS_ALPHABETA: 
                             startNewGame(AIDifficulty::ALPHA_BETA, AIDifficulty::HUMAN); break;
+                        case MainMenuOption::SELECT_AI_LEVEL: 
+                            alphaBetaLevel = (alphaBetaLevel + 1) % ABAI_DIFFICULTY_LEVEL_COUNT;
+                            std::cout << "[调试] 困难AI难度切换为: " << ABAI_DIFFICULTY_LEVELS[alphaBetaLevel].name << std::endl;
+                            break;
                         case MainMenuOption::SHOW_ABOUT: 
                             currentState = GameState::ABOUT_SCREEN; aboutTextScrollOffsetY = 0; break;
                         case MainMenuOption::SHOW_TASK_LOG: 
@@ -503,7 +519,8 @@ void Game::handleTaskLogScreenEvents(const SDL_Event& event) {
 void Game::aiTurn() {
      if (!players[currentPlayer] || gameOver) return;
      
-     Point aiMove = players[currentPlayer]->getMove(board, currentPlayer);
+     const int aiColor = currentPlayer;
+     Point aiMove = players[aiColor]->getMove(board, aiColor);
      
      if (board.isValidMove(aiMove.row, aiMove.col)) { 
         update(aiMove.row, aiMove.col);
@@ -529,6 +546,10 @@ void Game::aiTurn() {
             }
         }
      }
+     // 轮到人类思考时，AI 在后台搜索预期的应手
+     if (!gameOver && currentPlayer != aiColor && !players[currentPlayer] && players[aiColor]) {
+        players[aiColor]->startPondering(board, aiColor);
+     }
 }
 
 // 更新游戏逻辑
@@ -541,6 +562,10 @@ void Game::update(int row, int col) {
 
     if (placed) {
         lastPlayedMove = {row, col}; // 更新最后落子位置
+        // 通知双方的 AI，让它们增量更新内部状态
+        for (int color : {BLACK_PIECE, WHITE_PIECE}) {
+            if (players[color]) players[color]->onMovePlayed(row, col, playerWhoMoved);
+        }
         std::cout << "[信息] 玩家 " << playerWhoMoved << " 在 (" << row << ", " << col << ") 落子。" << std::endl;
         if (isHumanPlayer && currentState == GameState::PLAYING && !gameOver) {
             render(); 
@@ -562,7 +587,12 @@ void Game::update(int row, int col) {
             // 3. 切换玩家
             currentPlayer = (currentPlayer == BLACK_PIECE) ? WHITE_PIECE : BLACK_PIECE;
         }
-        if(gameOver) { std::cout << "[信息] " << gameMessage << std::endl; }
+        if(gameOver) {
+            std::cout << "[信息] " << gameMessage << std::endl;
+            for (int color : {BLACK_PIECE, WHITE_PIECE}) {
+                if (players[color]) players[color]->stopPondering();
+            }
+        }
     } else {
         if (isHumanPlayer) {
              std::cout << "[调试] 人类玩家无效落子于 (" << row << ", " << col << ") - placePiece返回false" << std::endl;
@@ -616,12 +646,18 @@ void Game::renderMenu() {
     SDL_Color exitBtnBgColor = {220,180,180,255}; 
     SDL_Color exitBtnTextColor = {100,0,0,255};   
 
+    const ABAIDifficultyLevel& level = ABAI_DIFFICULTY_LEVELS[alphaBetaLevel];
+    std::ostringstream levelText;
+    levelText << "困难AI难度: " << level.name << " (每步 <= " << std::fixed << std::setprecision(1)
+              << level.time_limit_ms / 1000.0 << " 秒)";
+
     std::map<MainMenuOption, std::string> buttonTexts = {
         {MainMenuOption::PLAYER_VS_PLAYER, "人人对战"},
         {MainMenuOption::HUMAN_AS_BLACK_VS_GREEDY, "执黑 vs 简单AI"},
         {MainMenuOption::HUMAN_AS_WHITE_VS_GREEDY, "执白 vs 简单AI"},
         {MainMenuOption::HUMAN_AS_BLACK_VS_ALPHABETA, "执黑 vs 困难AI"}, 
         {MainMenuOption::HUMAN_AS_WHITE_VS_ALPHABETA, "执白 vs 困难AI"}, 
+        {MainMenuOption::SELECT_AI_LEVEL, levelText.str()},
         {MainMenuOption::SHOW_ABOUT, "游戏说明与致谢"},
         {MainMenuOption::SHOW_TASK_LOG, "更新日志"},
         {MainMenuOption::EXIT_GAME, "退出游戏"}
@@ -784,6 +820,9 @@ void Game::startNewGame(AIDifficulty p1Type, AIDifficulty p2Type) {
     players[WHITE_PIECE] = createPlayer(p2Type);
     
     resetGameInternals(); // 会重置 lastPlayedMove
+    for (int color : {BLACK_PIECE, WHITE_PIECE}) {
+        if (players[color]) players[color]->onNewGame(); // 棋盘已清空
+    }
     currentState = GameState::PLAYING;
     std::cout << "[信息] 开始新游戏。P1类型: " << static_cast<int>(p1Type) 
               << ", P2类型: " << static_cast<int>(p2Type) << std::endl;
@@ -40,6 +40,7 @@ enum class MainMenuOption {
     HUMAN_AS_WHITE_VS_GREEDY,   // 人类执白 vs 简单AI
     HUMAN_AS_BLACK_VS_ALPHABETA,// 人类执黑 vs 困难AI
     HUMAN_AS_WHITE_VS_ALPHABETA,// 人类执白 vs 困难AI
+    SELECT_AI_LEVEL,            // 切换困难AI的难度等级
     SHOW_ABOUT,                 // 显示关于界面
     SHOW_TASK_LOG,              // 显示任务日志选项
     EXIT_GAME                   // 退出游戏
@@ -70,6 +71,7 @@ private:
     // --- 玩家管理 ---
     std::array<std::unique_ptr<Player>, 3> players;
     std::array<AIDifficulty, 3> playerTypes;
+    int alphaBetaLevel;  // 困难AI的难度等级 (ABAI_DIFFICULTY_LEVELS 的下标)
 
     // --- UI元素矩形区域 ---
     std::map<MainMenuOption, SDL_FRect> menuButtons;
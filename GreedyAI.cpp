@@ -1,6 +1,7 @@
 // Copyright (c) 2025 wibyuan
 // Licensed under the MIT License (see LICENSE for details)
 #include "GreedyAI.h"
+#include "PatternKernel.h" // 批量计算所有空位的落子增益
 #include <algorithm> // 用于 std::fill, std::max
 #include <limits>    // 用于 std::numeric_limits
 #include <cmath>     // 用于 std::abs
@@ -9,9 +10,13 @@
 
 // 构造函数: 初始化权重等
 GreedyAI::GreedyAI() : 
+    aiPlayerColor(EMPTY_PIECE), // 在 getMove 中设置
+    opponentColor(EMPTY_PIECE),
     k1_factor(3), 
     k2_factor(3),
-    currentTotalBoardScore(0) 
+    currentTotalBoardScore(0),
+    boardSynced(false),
+    scoreSynced(false)
 {
     std::cout << "[调试] GreedyAI 实例已创建。" << std::endl; // 修改调试输出为中文
     v_weights[0] = 0; 
@@ -119,14 +124,18 @@ void GreedyAI::updateBoardAndScore(int r, int c, int player) {
 
 // 初始化 AI 的内部状态 (棋盘和总评估分)
 void GreedyAI::initializeAIState(const Board& externalBoard) {
-    currentTotalBoardScore = 0; // 重置总评估分
     // 从外部棋盘复制状态到内部棋盘
     for(int r = 0; r < GAI_N; ++r) {
         for(int c = 0; c < GAI_N; ++c) {
             internalBoard[r][c] = externalBoard.getPiece(r, c);
         }
     }
-    // 根据复制后的内部棋盘，重新计算初始的总评估分
+    recalculateTotalScore();
+}
+
+// 根据内部棋盘重新计算总评估分
+void GreedyAI::recalculateTotalScore() {
+    currentTotalBoardScore = 0; // 重置总评估分
     for(int r = 0; r < GAI_N; ++r) {
         for(int c = 0; c < GAI_N; ++c) {
             // 注意：这里是对每个点调用calculateScoreContribution，
@@ -138,27 +147,60 @@ void GreedyAI::initializeAIState(const Board& externalBoard) {
     std::cout << "[调试] GreedyAI 初始棋盘分数 (currentTotalBoardScore): " << currentTotalBoardScore << std::endl;
 }
 
+// 总分是每个格子贡献之和，而每个 5 格窗口会被它包含的 5 个格子各计一次，
+// 所以一个格子变化时总分的变化是该格贡献变化的 5 倍
+void GreedyAI::applyNotifiedChange(int r, int c, int piece) {
+    if (!boardSynced || !isOk(r, c)) return;
+    if (scoreSynced) currentTotalBoardScore -= 5 * calculateScoreContribution(r, c);
+    internalBoard[r][c] = piece;
+    if (scoreSynced) currentTotalBoardScore += 5 * calculateScoreContribution(r, c);
+}
+
+void GreedyAI::onNewGame() {
+    for (auto& row : internalBoard) row.fill(EMPTY_PIECE);
+    currentTotalBoardScore = 0; // 空棋盘的总分与执子颜色无关
+    boardSynced = true;
+    scoreSynced = false; // 执子颜色在第一次 getMove 时才知道
+}
+
+void GreedyAI::onMovePlayed(int row, int col, int playerColor) {
+    applyNotifiedChange(row, col, playerColor);
+}
+
+void GreedyAI::onMoveUndone(int row, int col) {
+    applyNotifiedChange(row, col, EMPTY_PIECE);
+}
+
 
 // 获取 AI 的下一步棋
 Point GreedyAI::getMove(const Board& board, int playerColor) {
+    if (playerColor != aiPlayerColor) scoreSynced = false; // 总分是从执子方视角计算的
     aiPlayerColor = playerColor; // 设置AI执棋颜色
     opponentColor = (playerColor == BLACK_PIECE) ? WHITE_PIECE : BLACK_PIECE; // 设置对手颜色
 
-    initializeAIState(board); // 初始化AI的内部棋盘和评估分数
+    if (!boardSynced) {
+        initializeAIState(board); // 初始化AI的内部棋盘和评估分数
+    } else if (!scoreSynced) {
+        recalculateTotalScore(); // 内部棋盘已同步，只需按执子颜色计算一次总分
+        scoreSynced = true;
+    }
     
     int bestScoreForAI = std::numeric_limits<int>::min(); // AI能获得的最佳分数，初始化为最小值
     Point bestMove = {-1, -1}; // 最佳落子点，初始化为无效值
 
-    // 遍历棋盘所有空位，尝试落子并评估
+    // 一次算出所有空位的落子增益: 与逐格 updateBoardAndScore 落子/撤销得到的分数变化相同
+    PlacementGains gains;
+    computePlacementGains(internalBoard, v_weights, k2_factor, gains);
+    const auto& ai_gains = (aiPlayerColor == BLACK_PIECE) ? gains.black : gains.white;
+
+    // 遍历棋盘所有空位，评估落子后的分数
     for (int r_try = 0; r_try < GAI_N; ++r_try) {
         for (int c_try = 0; c_try < GAI_N; ++c_try) {
             if (internalBoard[r_try][c_try] == EMPTY_PIECE) { // 如果是空位
                 
-                // 模拟AI在此处落子
-                updateBoardAndScore(r_try, c_try, aiPlayerColor);
-                int scoreAfterAIMove = currentTotalBoardScore; // 获取AI落子后的棋盘总评估分
-                // 撤销模拟落子，恢复棋盘状态和总评估分
-                updateBoardAndScore(r_try, c_try, EMPTY_PIECE); 
+                // AI在此处落子后的棋盘总评估分
+                int scoreAfterAIMove = currentTotalBoardScore;
+                for (int dir = 0; dir < PK_LINES; ++dir) scoreAfterAIMove += ai_gains[dir][r_try * PK_GAIN_STRIDE + c_try];
 
                 bool updateBest = false; // 是否更新最佳走法的标志
                 if (bestMove.row == -1) { // 如果还没有找到任何有效走法
@@ -25,6 +25,11 @@ public:
     // 返回值: AI 计算出的最佳落子点 {row, col}
     Point getMove(const Board& board, int playerColor) override;
 
+    // 对局通知: 收到 onNewGame 后内部棋盘随每步棋增量更新，getMove 不再从棋盘复制
+    void onNewGame() override;
+    void onMovePlayed(int row, int col, int playerColor) override;
+    void onMoveUndone(int row, int col) override;
+
 private:
     // --- 成员变量 ---
     // AI 自己的棋子颜色
@@ -51,6 +56,11 @@ private:
     // 这个分数会在每次模拟落子或撤销时更新
     int currentTotalBoardScore;
 
+    // internalBoard 是否由对局通知维护 (与外部棋盘一致)
+    bool boardSynced;
+    // currentTotalBoardScore 是否对应 internalBoard 与当前 aiPlayerColor
+    bool scoreSynced;
+
     // --- 私有方法 ---
 
     // 辅助函数：检查坐标 (r, c) 是否在棋盘内
@@ -67,6 +77,12 @@ private:
 
     // 初始化 AI 的内部状态，包括 internalBoard 和 currentTotalBoardScore
     void initializeAIState(const Board& externalBoard);
+
+    // 根据 internalBoard 重新计算 currentTotalBoardScore
+    void recalculateTotalScore();
+
+    // 收到通知时更新 internalBoard，总分有效时同步更新
+    void applyNotifiedChange(int r, int c, int piece);
 };
 
 #endif // GREEDYAI_H
@@ -0,0 +1,271 @@
+// Copyright (c) 2025 wibyuan
+// Licensed under the MIT License (see LICENSE for details)
+#include "PatternKernel.h"
+
+// x86 上用 GCC/Clang 的 target 属性编译 SSE2/AVX2 版本，运行时再按 CPU 支持情况选择；
+// 其他平台只有标量版本
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PK_X86_DISPATCH 1
+#include <immintrin.h>
+#else
+#define PK_X86_DISPATCH 0
+#endif
+
+namespace {
+
+// 向量化的线状态布局: 四周各填充 4 格墙的棋盘，按行存储。
+// 从某个位置起、沿 dir 方向间隔 PK_LINE_STEP[dir] 的 5 个元素就是一个 5 格窗口，
+// 同一行上连续的几个格子对应的元素也是连续的，所以一次可以加载 4/8 个窗口的同一格。
+const int PK_PAD = 4;
+const int PK_PAD_STRIDE = PK_PAD + PK_GAIN_STRIDE + PK_PAD;
+const int PK_PAD_ROWS = PK_N + 2 * PK_PAD;
+const int PK_PAD_CELLS = PK_PAD_ROWS * PK_PAD_STRIDE;
+const int PK_PAD_SLACK = 32; // 末尾多留的墙，向量化时最后一组窗口可以越过有效范围读取
+const int PK_WALL = 3;
+const int PK_LINE_STEP[PK_LINES] = {1, PK_PAD_STRIDE, PK_PAD_STRIDE - 1, PK_PAD_STRIDE + 1};
+
+struct PaddedBoard {
+    alignas(32) int cells[PK_PAD_CELLS + PK_PAD_SLACK];
+};
+
+// 第一步的结果: 以每个位置为起点的窗口，在窗口内某个空位落黑/白子时的分数变化。
+// 窗口内有几个空位，这个值就会被几个格子共用，所以每个窗口只查一次表。
+struct WindowValues {
+    alignas(32) int black[PK_LINES][PK_PAD_CELLS + PK_PAD_SLACK];
+    alignas(32) int white[PK_LINES][PK_PAD_CELLS + PK_PAD_SLACK];
+};
+
+// 窗口分数表，按同色子数查表；超出 0..5 的项填 0
+// 对 nb 个黑子、nw 个白子、没有墙的窗口:
+//   落黑子: 没有白子时黑方分数增加 delta[nb]；没有黑子时白方分数 weights[nw] 清零，即增加 opponent[nw]
+//   落白子: 对称
+struct GainTables {
+    alignas(32) int delta[8];    // weights[n + 1] - weights[n]
+    alignas(32) int opponent[8]; // opponent_factor * weights[n]
+};
+
+int paddedIndex(int r, int c) {
+    return (r + PK_PAD) * PK_PAD_STRIDE + c + PK_PAD;
+}
+
+// 第一步只需要计算起点在此之前的窗口 (再往后的窗口不包含任何棋盘格)
+int windowLimit(int dir) {
+    return PK_PAD_CELLS - 4 * PK_LINE_STEP[dir];
+}
+
+void buildPaddedBoard(const std::array<std::array<int, PK_N>, PK_N>& board, PaddedBoard& padded) {
+    for (int& cell : padded.cells) cell = PK_WALL;
+    for (int r = 0; r < PK_N; ++r) {
+        for (int c = 0; c < PK_N; ++c) padded.cells[paddedIndex(r, c)] = board[r][c];
+    }
+}
+
+void buildGainTables(const std::array<int, PK_WEIGHTS_SIZE>& weights, int opponent_factor, GainTables& tables) {
+    int own[9] = {};
+    for (int n = 0; n < PK_WEIGHTS_SIZE; ++n) own[n] = weights[n];
+    for (int n = 0; n < 8; ++n) {
+        tables.delta[n] = n < PK_WEIGHTS_SIZE ? own[n + 1] - own[n] : 0;
+        tables.opponent[n] = opponent_factor * own[n];
+    }
+}
+
+// 标量版本 (参考实现)
+void computeGainsScalar(const PaddedBoard& padded, const GainTables& tables, WindowValues& windows, PlacementGains& gains) {
+    for (int dir = 0; dir < PK_LINES; ++dir) {
+        const int step = PK_LINE_STEP[dir];
+        for (int p = 0; p < windowLimit(dir); ++p) {
+            int nb = 0, nw = 0, walls = 0;
+            for (int k = 0; k < 5; ++k) {
+                int cell = padded.cells[p + k * step];
+                nb += (cell == 1);
+                nw += (cell == 2);
+                walls += (cell == PK_WALL);
+            }
+            int black_value = 0, white_value = 0;
+            if (walls == 0) { // 窗口完全在棋盘内
+                if (nw == 0) black_value += tables.delta[nb];
+                if (nb == 0) black_value += tables.opponent[nw];
+                if (nb == 0) white_value += tables.delta[nw];
+                if (nw == 0) white_value += tables.opponent[nb];
+            }
+            windows.black[dir][p] = black_value;
+            windows.white[dir][p] = white_value;
+        }
+        // 第二步: 每个空位的增益 = 包含它的 5 个窗口之和
+        for (int r = 0; r < PK_N; ++r) {
+            for (int c = 0; c < PK_GAIN_STRIDE; ++c) {
+                const int center = paddedIndex(r, c);
+                int black_gain = 0, white_gain = 0;
+                if (padded.cells[center] == 0) {
+                    for (int k = 0; k < 5; ++k) {
+                        black_gain += windows.black[dir][center - k * step];
+                        white_gain += windows.white[dir][center - k * step];
+                    }
+                }
+                gains.black[dir][r * PK_GAIN_STRIDE + c] = black_gain;
+                gains.white[dir][r * PK_GAIN_STRIDE + c] = white_gain;
+            }
+        }
+    }
+}
+
+#if PK_X86_DISPATCH
+
+// SSE2 没有按下标取表的指令: 先求出计数等于 0..5 的掩码，再用掩码拼出查表结果
+struct CountMasksSse2 {
+    __m128i equals[PK_WEIGHTS_SIZE];
+};
+
+__attribute__((target("sse2")))
+void buildCountMasksSse2(__m128i count, CountMasksSse2& masks) {
+    for (int n = 0; n < PK_WEIGHTS_SIZE; ++n) masks.equals[n] = _mm_cmpeq_epi32(count, _mm_set1_epi32(n));
+}
+
+__attribute__((target("sse2")))
+__m128i lookupSse2(const int* table, const CountMasksSse2& masks) {
+    __m128i result = _mm_and_si128(masks.equals[0], _mm_set1_epi32(table[0]));
+    for (int n = 1; n < PK_WEIGHTS_SIZE; ++n) {
+        result = _mm_or_si128(result, _mm_and_si128(masks.equals[n], _mm_set1_epi32(table[n])));
+    }
+    return result;
+}
+
+// SSE2 版本: 一次处理 4 个窗口 / 4 个格子
+__attribute__((target("sse2")))
+void computeGainsSse2(const PaddedBoard& padded, const GainTables& tables, WindowValues& windows, PlacementGains& gains) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i black = _mm_set1_epi32(1);
+    const __m128i white = _mm_set1_epi32(2);
+    const __m128i wall = _mm_set1_epi32(PK_WALL);
+    for (int dir = 0; dir < PK_LINES; ++dir) {
+        const int step = PK_LINE_STEP[dir];
+        for (int p = 0; p < windowLimit(dir); p += 4) {
+            __m128i nb = zero, nw = zero, walls = zero;
+            for (int k = 0; k < 5; ++k) {
+                __m128i cells = _mm_loadu_si128(reinterpret_cast<const __m128i*>(padded.cells + p + k * step));
+                nb = _mm_sub_epi32(nb, _mm_cmpeq_epi32(cells, black));
+                nw = _mm_sub_epi32(nw, _mm_cmpeq_epi32(cells, white));
+                walls = _mm_or_si128(walls, _mm_cmpeq_epi32(cells, wall));
+            }
+            CountMasksSse2 black_masks, white_masks;
+            buildCountMasksSse2(nb, black_masks);
+            buildCountMasksSse2(nw, white_masks);
+            const __m128i no_black = black_masks.equals[0];
+            const __m128i no_white = white_masks.equals[0];
+            const __m128i black_value = _mm_add_epi32(_mm_and_si128(no_white, lookupSse2(tables.delta, black_masks)),
+                                                      _mm_and_si128(no_black, lookupSse2(tables.opponent, white_masks)));
+            const __m128i white_value = _mm_add_epi32(_mm_and_si128(no_black, lookupSse2(tables.delta, white_masks)),
+                                                      _mm_and_si128(no_white, lookupSse2(tables.opponent, black_masks)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(windows.black[dir] + p), _mm_andnot_si128(walls, black_value));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(windows.white[dir] + p), _mm_andnot_si128(walls, white_value));
+        }
+        for (int r = 0; r < PK_N; ++r) {
+            for (int c = 0; c < PK_GAIN_STRIDE; c += 4) {
+                const int center = paddedIndex(r, c);
+                __m128i black_gain = zero, white_gain = zero;
+                for (int k = 0; k < 5; ++k) {
+                    black_gain = _mm_add_epi32(black_gain, _mm_loadu_si128(reinterpret_cast<const __m128i*>(windows.black[dir] + center - k * step)));
+                    white_gain = _mm_add_epi32(white_gain, _mm_loadu_si128(reinterpret_cast<const __m128i*>(windows.white[dir] + center - k * step)));
+                }
+                // 只有空位有增益
+                const __m128i empty = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(padded.cells + center)), zero);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&gains.black[dir][r * PK_GAIN_STRIDE + c]), _mm_and_si128(empty, black_gain));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&gains.white[dir][r * PK_GAIN_STRIDE + c]), _mm_and_si128(empty, white_gain));
+            }
+        }
+    }
+}
+
+// AVX2 版本: 一次处理 8 个窗口 / 8 个格子，查表用 8 通道的置换指令
+__attribute__((target("avx2")))
+void computeGainsAvx2(const PaddedBoard& padded, const GainTables& tables, WindowValues& windows, PlacementGains& gains) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i black = _mm256_set1_epi32(1);
+    const __m256i white = _mm256_set1_epi32(2);
+    const __m256i wall = _mm256_set1_epi32(PK_WALL);
+    const __m256i delta_table = _mm256_load_si256(reinterpret_cast<const __m256i*>(tables.delta));
+    const __m256i opponent_table = _mm256_load_si256(reinterpret_cast<const __m256i*>(tables.opponent));
+    for (int dir = 0; dir < PK_LINES; ++dir) {
+        const int step = PK_LINE_STEP[dir];
+        for (int p = 0; p < windowLimit(dir); p += 8) {
+            __m256i nb = zero, nw = zero, walls = zero;
+            for (int k = 0; k < 5; ++k) {
+                __m256i cells = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(padded.cells + p + k * step));
+                nb = _mm256_sub_epi32(nb, _mm256_cmpeq_epi32(cells, black));
+                nw = _mm256_sub_epi32(nw, _mm256_cmpeq_epi32(cells, white));
+                walls = _mm256_or_si256(walls, _mm256_cmpeq_epi32(cells, wall));
+            }
+            const __m256i no_black = _mm256_cmpeq_epi32(nb, zero);
+            const __m256i no_white = _mm256_cmpeq_epi32(nw, zero);
+            const __m256i black_value = _mm256_add_epi32(_mm256_and_si256(no_white, _mm256_permutevar8x32_epi32(delta_table, nb)),
+                                                         _mm256_and_si256(no_black, _mm256_permutevar8x32_epi32(opponent_table, nw)));
+            const __m256i white_value = _mm256_add_epi32(_mm256_and_si256(no_black, _mm256_permutevar8x32_epi32(delta_table, nw)),
+                                                         _mm256_and_si256(no_white, _mm256_permutevar8x32_epi32(opponent_table, nb)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(windows.black[dir] + p), _mm256_andnot_si256(walls, black_value));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(windows.white[dir] + p), _mm256_andnot_si256(walls, white_value));
+        }
+        for (int r = 0; r < PK_N; ++r) {
+            for (int c = 0; c < PK_GAIN_STRIDE; c += 8) {
+                const int center = paddedIndex(r, c);
+                __m256i black_gain = zero, white_gain = zero;
+                for (int k = 0; k < 5; ++k) {
+                    black_gain = _mm256_add_epi32(black_gain, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(windows.black[dir] + center - k * step)));
+                    white_gain = _mm256_add_epi32(white_gain, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(windows.white[dir] + center - k * step)));
+                }
+                const __m256i empty = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(padded.cells + center)), zero);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(&gains.black[dir][r * PK_GAIN_STRIDE + c]), _mm256_and_si256(empty, black_gain));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(&gains.white[dir][r * PK_GAIN_STRIDE + c]), _mm256_and_si256(empty, white_gain));
+            }
+        }
+    }
+}
+
+#endif // PK_X86_DISPATCH
+
+} // namespace
+
+PatternKernelPath bestPatternKernelPath() {
+#if PK_X86_DISPATCH
+    static const PatternKernelPath best = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return PatternKernelPath::AVX2;
+        if (__builtin_cpu_supports("sse2")) return PatternKernelPath::SSE2;
+        return PatternKernelPath::SCALAR;
+    }();
+    return best;
+#else
+    return PatternKernelPath::SCALAR;
+#endif
+}
+
+const char* patternKernelPathName(PatternKernelPath path) {
+    switch (path) {
+    case PatternKernelPath::AVX2: return "AVX2";
+    case PatternKernelPath::SSE2: return "SSE2";
+    default: return "标量";
+    }
+}
+
+void computePlacementGains(const std::array<std::array<int, PK_N>, PK_N>& board,
+                           const std::array<int, PK_WEIGHTS_SIZE>& weights, int opponent_factor,
+                           PlacementGains& gains, PatternKernelPath path) {
+    PaddedBoard padded;
+    GainTables tables;
+    WindowValues windows;
+    buildPaddedBoard(board, padded);
+    buildGainTables(weights, opponent_factor, tables);
+#if PK_X86_DISPATCH
+    // 请求的指令集不可用时退回较低的一级
+    if (path == PatternKernelPath::AVX2 && bestPatternKernelPath() == PatternKernelPath::AVX2) {
+        computeGainsAvx2(padded, tables, windows, gains);
+        return;
+    }
+    if (path != PatternKernelPath::SCALAR && bestPatternKernelPath() != PatternKernelPath::SCALAR) {
+        computeGainsSse2(padded, tables, windows, gains);
+        return;
+    }
+#else
+    (void)path;
+#endif
+    computeGainsScalar(padded, tables, windows, gains);
+}
@@ -0,0 +1,44 @@
+#ifndef PATTERNKERNEL_H
+#define PATTERNKERNEL_H
+// Copyright (c) 2025 wibyuan
+// Licensed under the MIT License (see LICENSE for details)
+
+#include <array>
+
+const int PK_N = 15;                        // 棋盘维度
+const int PK_LINES = 4;                     // 方向数: 0 水平, 1 垂直, 2 r+c 相同, 3 r-c 相同
+const int PK_GAIN_STRIDE = 16;              // 输出数组的行跨度 (每行多出 1 格，便于整块写入)
+const int PK_GAIN_SIZE = PK_N * PK_GAIN_STRIDE;
+const int PK_WEIGHTS_SIZE = 6;              // 5 格窗口中 0..5 个同色子的分数
+
+// 批量评分的实现: 运行时按 CPU 支持的指令集选择，三者结果逐位相同
+enum class PatternKernelPath {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// 每个空位分别落下黑/白子后，从落子方视角的分数变化 (己方窗口分数变化 - 系数 * 对方窗口分数变化)。
+// 只统计包含该格、且完全在棋盘内的 5 格窗口，按方向分别给出；有子的格子为 0。
+// 下标为 行 * PK_GAIN_STRIDE + 列。
+struct PlacementGains {
+    std::array<std::array<int, PK_GAIN_SIZE>, PK_LINES> black;
+    std::array<std::array<int, PK_GAIN_SIZE>, PK_LINES> white;
+};
+
+// 当前机器上最快的实现 (首次调用时检测一次)
+PatternKernelPath bestPatternKernelPath();
+const char* patternKernelPathName(PatternKernelPath path);
+
+// 对整个棋盘计算落子增益。board 中 0 为空, 1 为黑, 2 为白。
+// weights[n] 为 5 格窗口中有 n 个同色子且没有对方棋子时的分数，opponent_factor 为对方分数的系数。
+void computePlacementGains(const std::array<std::array<int, PK_N>, PK_N>& board,
+                           const std::array<int, PK_WEIGHTS_SIZE>& weights, int opponent_factor,
+                           PlacementGains& gains, PatternKernelPath path);
+inline void computePlacementGains(const std::array<std::array<int, PK_N>, PK_N>& board,
+                                  const std::array<int, PK_WEIGHTS_SIZE>& weights, int opponent_factor,
+                                  PlacementGains& gains) {
+    computePlacementGains(board, weights, opponent_factor, gains, bestPatternKernelPath());
+}
+
+#endif // PATTERNKERNEL_H
@@ -23,6 +23,23 @@ public:
     // 返回值:
     //   Point: AI 计算出的最佳落子位置 (行, 列)
     virtual Point getMove(const Board& board, int playerColor) = 0; 
+
+    // 对局通知 (默认什么也不做)
+    // 收到 onNewGame 后，之后棋盘上的每一次变化都会通过 onMovePlayed / onMoveUndone 告知，
+    // 引擎可以据此增量维护内部状态，不必在每次 getMove 时从棋盘重建。
+    //   onNewGame: 新的一局开始，棋盘为空
+    //   onMovePlayed: playerColor (BLACK_PIECE 或 WHITE_PIECE) 在 (row, col) 落子，双方的落子都会通知
+    //   onMoveUndone: (row, col) 上的棋子被撤回
+    virtual void onNewGame() {}
+    virtual void onMovePlayed(int row, int col, int playerColor) { (void)row; (void)col; (void)playerColor; }
+    virtual void onMoveUndone(int row, int col) { (void)row; (void)col; }
+
+    // 后台思考 (默认什么也不做)
+    //   startPondering: 自己 (playerColor) 刚落完子、轮到对手思考时调用，board 为当前局面。
+    //                   引擎可以在后台猜测对手的应手并提前搜索，之后的 getMove 猜中时可立即返回
+    //   stopPondering: 停止后台思考 (例如对局结束)
+    virtual void startPondering(const Board& board, int playerColor) { (void)board; (void)playerColor; }
+    virtual void stopPondering() {}
 };
 
 #endif // PLAYER_H
@@ -0,0 +1,268 @@
+// Copyright (c) 2025 wibyuan
+// Licensed under the MIT License (see LICENSE for details)
+#include "ProofNumberAI.h"
+#include <algorithm>
+#include <iostream>  // 用于调试输出
+
+namespace {
+
+std::uint32_t saturatingAdd(std::uint32_t a, std::uint32_t b) {
+    std::uint64_t sum = static_cast<std::uint64_t>(a) + b;
+    return sum >= PNAI_INFINITY ? PNAI_INFINITY : static_cast<std::uint32_t>(sum);
+}
+
+} // namespace
+
+ProofNumberAI::ProofNumberAI(int proofTableSizeMB, long long nodeLimit) :
+    AlphaBetaAI(),
+    proof_bucket_num(0),
+    node_limit_nl(nodeLimit),
+    nodes_searched_pn(0),
+    attacker_ak(1),
+    node_buffers_nb(new ProofNodeBuffer[PNAI_MAX_DEPTH + 1])
+{
+    setProofTableSize(proofTableSizeMB);
+}
+
+void ProofNumberAI::setProofTableSize(int size_mb) {
+    std::size_t bytes = static_cast<std::size_t>(size_mb > 0 ? size_mb : 1) * 1024 * 1024;
+    std::size_t max_buckets = bytes / sizeof(ProofBucket);
+    std::size_t bucket_num = 1;
+    while (bucket_num * 2 <= max_buckets) bucket_num *= 2; // 2 的幂，便于用掩码取下标
+    proof_table_pt.reset(new ProofBucket[bucket_num]());
+    proof_bucket_num = bucket_num;
+    std::cout << "[调试] 证明表已分配: " << proof_bucket_num << " 个桶, "
+              << proof_bucket_num * sizeof(ProofBucket) / 1024 << " KB。" << std::endl;
+}
+
+// 没有记录的节点按 (1, 1) 处理。证明表在多次 solve 之间保留，
+// 在更深处 (剩余层数更少) 得到的否证对更浅的查询不可信，同样按 (1, 1) 处理
+void ProofNumberAI::lookupProof(std::uint64_t key, int remaining_depth, std::uint32_t& proof, std::uint32_t& disproof) const {
+    const ProofBucket& bucket = proof_table_pt[key & (proof_bucket_num - 1)];
+    for (const ProofEntry& entry : bucket.entries) {
+        if (entry.key == key && !(entry.disproof == 0 && entry.remaining_depth < remaining_depth)) {
+            proof = entry.proof;
+            disproof = entry.disproof;
+            return;
+        }
+    }
+    proof = 1;
+    disproof = 1;
+}
+
+// 替换顺序: 同一局面 > 空条目 > 搜索量最小的条目
+void ProofNumberAI::storeProof(std::uint64_t key, int remaining_depth, std::uint32_t proof, std::uint32_t disproof, std::uint32_t work, int best_move) {
+    ProofBucket& bucket = proof_table_pt[key & (proof_bucket_num - 1)];
+    ProofEntry* target = &bucket.entries[0];
+    for (ProofEntry& entry : bucket.entries) {
+        if (entry.key == key || entry.key == 0) {
+            target = &entry;
+            break;
+        }
+        if (entry.work < target->work) target = &entry;
+    }
+    if (target->key == key) work = saturatingAdd(work, target->work);
+    target->key = key;
+    target->proof = proof;
+    target->disproof = disproof;
+    target->work = work;
+    target->best_move = static_cast<std::int16_t>(best_move);
+    target->remaining_depth = static_cast<std::int16_t>(remaining_depth);
+}
+
+std::size_t ProofNumberAI::countProofEntries() const {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < proof_bucket_num; ++i) {
+        for (const ProofEntry& entry : proof_table_pt[i].entries) {
+            if (entry.key != 0) ++count;
+        }
+    }
+    return count;
+}
+
+// 证明表的键: 棋子哈希 + 轮到谁下 + 进攻方
+std::uint64_t ProofNumberAI::proofKey(int player) const {
+    return current_hash_key_zh ^ zobrist_side_keys_zs[player] ^ zobrist_ai_color_keys_za[attacker_ak];
+}
+
+// 进攻方 (OR 节点): 成五 > 挡对方成五点 > 冲四/活三
+// 防守方 (AND 节点): 自己成五 > 挡进攻方成五点 > 化解活三或冲四
+bool ProofNumberAI::generateProofMoves(int player, int* moves, int& move_count, std::uint32_t& proof, std::uint32_t& disproof) {
+    const int opponent = 3 - player;
+    const bool is_attacker = (player == attacker_ak);
+    std::array<int, ABAI_N * ABAI_N> points;
+    move_count = 0;
+
+    // 当前一方能成五
+    if (collectFivePoints(player, points) > 0) {
+        proof = is_attacker ? 0 : PNAI_INFINITY;
+        disproof = is_attacker ? PNAI_INFINITY : 0;
+        return true;
+    }
+    // 对方有成五点: 两个以上挡不住，一个则必须去挡
+    int opponent_fives = collectFivePoints(opponent, points);
+    if (opponent_fives >= 2) {
+        proof = is_attacker ? PNAI_INFINITY : 0;
+        disproof = is_attacker ? 0 : PNAI_INFINITY;
+        return true;
+    }
+    if (opponent_fives == 1) {
+        moves[0] = points[0];
+        move_count = 1;
+        return false;
+    }
+
+    if (is_attacker) {
+        move_count = generateThreatMoves(player, true, moves);
+        if (move_count == 0) { // 没有威胁可走，无法证明
+            proof = PNAI_INFINITY;
+            disproof = 0;
+            return true;
+        }
+    } else {
+        if (!generateThreatDefences(opponent, moves, move_count)) { // 进攻方没有威胁，防守方脱先即可
+            proof = PNAI_INFINITY;
+            disproof = 0;
+            return true;
+        }
+        if (move_count == 0) { // 挡不住
+            proof = 0;
+            disproof = PNAI_INFINITY;
+            return true;
+        }
+    }
+    return false;
+}
+
+// df-pn 的 MID 过程: 在阈值以内展开节点，超过阈值或决出胜负后返回，结果写入证明表
+// 返回本次调用访问的节点数
+std::uint32_t ProofNumberAI::searchProofNode(int player, std::uint32_t proof_threshold, std::uint32_t disproof_threshold, int depth) {
+    ++nodes_searched_pn;
+    const std::uint64_t key = proofKey(player);
+    ProofNodeBuffer& buffer = node_buffers_nb[depth];
+    int* const moves = buffer.moves.data();
+    std::uint32_t* const child_proof = buffer.child_proof.data();
+    std::uint32_t* const child_disproof = buffer.child_disproof.data();
+    int generated_count = 0;
+    std::uint32_t proof = 1, disproof = 1;
+    if (generateProofMoves(player, moves, generated_count, proof, disproof)) {
+        storeProof(key, PNAI_MAX_DEPTH, proof, disproof, 1, -1); // 直接决出，与层数无关
+        return 1;
+    }
+    if (depth >= PNAI_MAX_DEPTH) { // 太深，在这一层按无法证明处理 (更浅处遇到同一局面时会重新搜索)
+        storeProof(key, 0, PNAI_INFINITY, 0, 1, -1);
+        return 1;
+    }
+    const int remaining_depth = PNAI_MAX_DEPTH - depth;
+
+    const bool is_or_node = (player == attacker_ak);
+    const int child_player = 3 - player;
+    const long long start_nodes = nodes_searched_pn;
+    const std::size_t move_count = static_cast<std::size_t>(generated_count);
+    int best_move = -1;
+
+    for (;;) {
+        // 从证明表读取子节点，汇总出本节点的证明数/否证数
+        std::size_t best_child = 0;
+        std::uint32_t second_value = PNAI_INFINITY;
+        proof = is_or_node ? PNAI_INFINITY : 0;
+        disproof = is_or_node ? 0 : PNAI_INFINITY;
+        for (std::size_t i = 0; i < move_count; ++i) {
+            const std::uint64_t child_key = current_hash_key_zh ^ zobrist_keys_zb[moves[i]][player] ^
+                                            zobrist_side_keys_zs[child_player] ^ zobrist_ai_color_keys_za[attacker_ak];
+            lookupProof(child_key, remaining_depth - 1, child_proof[i], child_disproof[i]);
+            // OR 节点选证明数最小的子节点，AND 节点选否证数最小的子节点
+            std::uint32_t value = is_or_node ? child_proof[i] : child_disproof[i];
+            std::uint32_t best_value = is_or_node ? child_proof[best_child] : child_disproof[best_child];
+            if (i > 0 && value < best_value) {
+                second_value = best_value;
+                best_child = i;
+            } else if (i > 0 && value < second_value) {
+                second_value = value;
+            }
+            if (is_or_node) {
+                proof = std::min(proof, child_proof[i]);
+                disproof = saturatingAdd(disproof, child_disproof[i]);
+            } else {
+                proof = saturatingAdd(proof, child_proof[i]);
+                disproof = std::min(disproof, child_disproof[i]);
+            }
+        }
+        best_move = moves[best_child];
+        if (proof >= proof_threshold || disproof >= disproof_threshold || nodes_searched_pn >= node_limit_nl) break;
+
+        std::uint32_t child_proof_threshold, child_disproof_threshold;
+        if (is_or_node) {
+            child_proof_threshold = std::min(proof_threshold, saturatingAdd(second_value, 1));
+            child_disproof_threshold = std::min(PNAI_INFINITY, saturatingAdd(disproof_threshold - disproof, child_disproof[best_child]));
+        } else {
+            child_proof_threshold = std::min(PNAI_INFINITY, saturatingAdd(proof_threshold - proof, child_proof[best_child]));
+            child_disproof_threshold = std::min(disproof_threshold, saturatingAdd(second_value, 1));
+        }
+        int r = best_move / ABAI_N, c = best_move % ABAI_N;
+        updateAIInternalState(r, c, player);
+        searchProofNode(child_player, child_proof_threshold, child_disproof_threshold, depth + 1);
+        updateAIInternalState(r, c, 0);
+    }
+
+    long long work = nodes_searched_pn - start_nodes + 1;
+    storeProof(key, remaining_depth, proof, disproof, static_cast<std::uint32_t>(std::min<long long>(work, PNAI_INFINITY)), best_move);
+    return static_cast<std::uint32_t>(std::min<long long>(work, PNAI_INFINITY));
+}
+
+ProofNumberResult ProofNumberAI::solve(const Board& board, int playerColor) {
+    ProofNumberResult result;
+    aiPlayerColor_op = playerColor == BLACK_PIECE ? 1 : 2;
+    attacker_ak = aiPlayerColor_op;
+    syncAIStateWithBoard(board);
+    nodes_searched_pn = 0;
+
+    // 根节点以无穷大的阈值展开，直到决出结果或节点用完
+    searchProofNode(attacker_ak, PNAI_INFINITY, PNAI_INFINITY, 0);
+
+    std::uint32_t proof, disproof;
+    lookupProof(proofKey(attacker_ak), PNAI_MAX_DEPTH, proof, disproof);
+    result.nodes = nodes_searched_pn;
+    result.table_entries = countProofEntries();
+    if (proof == 0) {
+        result.status = ProofNumberResult::Status::PROVEN;
+        // 证明数为 0 的子节点就是必胜的第一步
+        std::array<int, ABAI_N * ABAI_N> points;
+        if (collectFivePoints(attacker_ak, points) > 0) {
+            result.winning_move.row = points[0] / ABAI_N;
+            result.winning_move.col = points[0] % ABAI_N;
+        } else {
+            int* const moves = node_buffers_nb[0].moves.data();
+            int move_count = 0;
+            std::uint32_t root_proof, root_disproof;
+            generateProofMoves(attacker_ak, moves, move_count, root_proof, root_disproof);
+            for (int i = 0; i < move_count; ++i) {
+                const int move_idx = moves[i];
+                std::uint32_t child_proof, child_disproof;
+                lookupProof(current_hash_key_zh ^ zobrist_keys_zb[move_idx][attacker_ak] ^
+                            zobrist_side_keys_zs[3 - attacker_ak] ^ zobrist_ai_color_keys_za[attacker_ak],
+                            PNAI_MAX_DEPTH - 1, child_proof, child_disproof);
+                if (child_proof == 0) {
+                    result.winning_move.row = move_idx / ABAI_N;
+                    result.winning_move.col = move_idx % ABAI_N;
+                    break;
+                }
+            }
+        }
+    } else if (disproof == 0) {
+        result.status = ProofNumberResult::Status::DISPROVEN;
+    }
+    std::cout << "[AI 调试] 证明数搜索: 状态=" << static_cast<int>(result.status) << ", 节点数=" << result.nodes
+              << ", 证明表条目=" << result.table_entries << std::endl;
+    return result;
+}
+
+Point ProofNumberAI::getMove(const Board& board, int playerColor) {
+    ProofNumberResult result = solve(board, playerColor);
+    if (result.status == ProofNumberResult::Status::PROVEN && result.winning_move.row >= 0) {
+        std::cout << "[AI] ProofNumberAI 已证明必胜，走 行=" << result.winning_move.row
+                  << ", 列=" << result.winning_move.col << std::endl;
+        return result.winning_move;
+    }
+    return AlphaBetaAI::getMove(board, playerColor); // 没有证明必胜，交给 Alpha-Beta 搜索
+}
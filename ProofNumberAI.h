@@ -0,0 +1,85 @@
+#ifndef PROOFNUMBERAI_H
+#define PROOFNUMBERAI_H
+// Copyright (c) 2025 wibyuan
+// Licensed under the MIT License (see LICENSE for details)
+
+#include "AlphaBetaAI.h"
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <memory>
+
+const std::uint32_t PNAI_INFINITY = 100000000; // 证明数/否证数的无穷大
+const int PNAI_DEFAULT_TABLE_SIZE_MB = 32;     // 证明表默认大小 (MB)
+const long long PNAI_DEFAULT_NODE_LIMIT = 500000; // 单次求解的节点上限
+const int PNAI_MAX_DEPTH = 60;                 // 搜索的最大层数，超过后视为无法证明
+
+// 证明数搜索的结果
+struct ProofNumberResult {
+    enum class Status {
+        PROVEN,     // 在威胁空间内证明了必胜，winning_move 为第一步
+        DISPROVEN,  // 在威胁空间内不存在必胜 (不代表整盘棋没有胜法)
+        UNKNOWN     // 预算用完，未能得出结论
+    };
+    Status status = Status::UNKNOWN;
+    Point winning_move;
+    long long nodes = 0;       // 访问的节点数
+    std::size_t table_entries = 0; // 证明表中被占用的条目数
+};
+
+// 深度优先证明数搜索 (df-pn)，用于回答残局 "是否必胜" 的问题。
+// 复用 AlphaBetaAI 的棋盘、线状态与棋型识别: 进攻方 (OR 节点) 只走成五、挡成五点、冲四和活三，
+// 防守方 (AND 节点) 只走挡成五点、化解活三的点和自己的冲四，与算杀使用同一套走法生成。
+// 证明表大小固定，满了之后按搜索量替换旧条目。
+// 作为玩家时，证明了必胜就直接走，否则退回 AlphaBetaAI 的搜索。
+class ProofNumberAI : public AlphaBetaAI {
+public:
+    explicit ProofNumberAI(int proofTableSizeMB = PNAI_DEFAULT_TABLE_SIZE_MB, long long nodeLimit = PNAI_DEFAULT_NODE_LIMIT);
+    Point getMove(const Board& board, int playerColor) override;
+
+    // 分析入口: 判断 playerColor 在当前局面 (轮到 playerColor 下棋) 是否必胜
+    ProofNumberResult solve(const Board& board, int playerColor);
+
+    void setNodeLimit(long long node_limit) { node_limit_nl = node_limit; }
+    void setProofTableSize(int size_mb);
+
+private:
+    // 证明表条目: key 为 0 表示空
+    struct ProofEntry {
+        std::uint64_t key;
+        std::uint32_t proof;       // 证明数
+        std::uint32_t disproof;    // 否证数
+        std::uint32_t work;        // 该节点下的搜索量，替换时保留搜索量大的条目
+        std::int16_t best_move;    // 最近一次选择的子节点走法
+        std::int16_t remaining_depth; // 存入时距 PNAI_MAX_DEPTH 的层数。否证可能只是碰到了层数上限，
+                                      // 只对剩余层数不多于它的查询有效；直接决出的局面记为 PNAI_MAX_DEPTH
+    };
+    static const int PROOF_BUCKET_SIZE = 2;
+    struct ProofBucket {
+        ProofEntry entries[PROOF_BUCKET_SIZE];
+    };
+
+    std::unique_ptr<ProofBucket[]> proof_table_pt;
+    std::size_t proof_bucket_num;
+    long long node_limit_nl;
+    long long nodes_searched_pn;
+    int attacker_ak;
+    // 每层一组走法与子节点证明数/否证数的缓冲区 (PNAI_MAX_DEPTH + 1 层)，搜索过程中不分配堆内存
+    struct ProofNodeBuffer {
+        std::array<int, ABAI_N * ABAI_N> moves;
+        std::array<std::uint32_t, ABAI_N * ABAI_N> child_proof;
+        std::array<std::uint32_t, ABAI_N * ABAI_N> child_disproof;
+    };
+    std::unique_ptr<ProofNodeBuffer[]> node_buffers_nb;
+
+    void lookupProof(std::uint64_t key, int remaining_depth, std::uint32_t& proof, std::uint32_t& disproof) const;
+    void storeProof(std::uint64_t key, int remaining_depth, std::uint32_t proof, std::uint32_t disproof, std::uint32_t work, int best_move);
+    std::size_t countProofEntries() const;
+
+    // 生成 player 的走法写入 moves (至少 ABAI_N * ABAI_N 项)；返回 true 表示当前局面已决出 (proof/disproof 已填好)
+    bool generateProofMoves(int player, int* moves, int& move_count, std::uint32_t& proof, std::uint32_t& disproof);
+    std::uint32_t searchProofNode(int player, std::uint32_t proof_threshold, std::uint32_t disproof_threshold, int depth);
+    std::uint64_t proofKey(int player) const;
+};
+
+#endif // PROOFNUMBERAI_H
@@ -0,0 +1,61 @@
+// Copyright (c) 2025 wibyuan
+// Licensed under the MIT License (see LICENSE for details)
+#include "SearchTrace.h"
+#include <iostream>  // 用于调试输出
+
+SearchTraceWriter::SearchTraceWriter() :
+    file(nullptr),
+    buffered_count(0),
+    written_count(0)
+{
+}
+
+SearchTraceWriter::~SearchTraceWriter() {
+    close();
+}
+
+bool SearchTraceWriter::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "[错误] 无法创建搜索追踪文件: " << path << std::endl;
+        return false;
+    }
+    SearchTraceHeader header = {STRACE_MAGIC, STRACE_VERSION, static_cast<std::uint32_t>(sizeof(SearchTraceRecord))};
+    std::fwrite(&header, sizeof(header), 1, file);
+    buffered_count = 0;
+    written_count = 0;
+    return true;
+}
+
+void SearchTraceWriter::close() {
+    if (file == nullptr) return;
+    flush();
+    std::fclose(file);
+    file = nullptr;
+}
+
+void SearchTraceWriter::flush() {
+    if (buffered_count == 0) return;
+    if (file != nullptr) std::fwrite(buffer.data(), sizeof(SearchTraceRecord), buffered_count, file);
+    written_count += static_cast<long long>(buffered_count);
+    buffered_count = 0;
+}
+
+bool readSearchTrace(const std::string& path, std::vector<SearchTraceRecord>& records) {
+    records.clear();
+    std::FILE* in = std::fopen(path.c_str(), "rb");
+    if (in == nullptr) return false;
+    SearchTraceHeader header;
+    bool ok = std::fread(&header, sizeof(header), 1, in) == 1 && header.magic == STRACE_MAGIC &&
+              header.version == STRACE_VERSION && header.record_size == sizeof(SearchTraceRecord);
+    if (ok) {
+        std::array<SearchTraceRecord, STRACE_BUFFER_RECORDS> chunk;
+        std::size_t count;
+        while ((count = std::fread(chunk.data(), sizeof(SearchTraceRecord), chunk.size(), in)) > 0) {
+            records.insert(records.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(count));
+        }
+    }
+    std::fclose(in);
+    return ok;
+}
@@ -0,0 +1,95 @@
+#ifndef SEARCHTRACE_H
+#define SEARCHTRACE_H
+// Copyright (c) 2025 wibyuan
+// Licensed under the MIT License (see LICENSE for details)
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// 搜索树追踪文件: 16 字节文件头 + 若干条 24 字节的节点记录 (本机字节序)。
+// alphaBetaSearch 在每个节点返回时写一条记录 (后序)，子节点的记录总是排在父节点之前，
+// 离线工具按 ply 重建出整棵树。每次迭代加深开始时先写一条 SEARCH_BEGIN 记录。
+const std::uint64_t STRACE_MAGIC = 0x3130435254594257ULL; // "WBYTRC01"
+const std::uint32_t STRACE_VERSION = 1;
+const std::size_t STRACE_BUFFER_RECORDS = 4096;           // 写入缓冲区的记录数，满了才写文件
+const std::int16_t STRACE_NO_MOVE = -1;                   // 根节点没有到达它的走法
+const std::int16_t STRACE_NULL_MOVE = -2;                 // 空着裁剪中让对方连走的子节点
+
+// 节点以什么方式结束
+enum class SearchTraceReason : std::uint8_t {
+    SEARCH_BEGIN = 0, // 一次迭代加深的开始 (不是节点): depth 为目标深度, side 为 AI 颜色, subtree_nodes 为棋子数
+    ABORTED,          // 预算用完，结果作废
+    TERMINAL,         // 已分出胜负或到达最大层数
+    LEAF,             // 到达名义深度，转入静态搜索 (subtree_nodes 含静态搜索节点)
+    TT_CUTOFF,        // 置换表截断
+    NULL_MOVE_CUTOFF, // 验证空着裁剪成功
+    NO_MOVES,         // 没有可搜索的走法
+    BETA_CUTOFF,      // 第 cut_index 个走法引起剪枝
+    EXACT,            // 所有走法都搜完，结果落在窗口内
+    FAIL_LOW          // 所有走法都搜完，没有一个改进当前一方的窗口边界
+};
+
+// 节点记录的附加标记
+enum SearchTraceFlag : std::uint8_t {
+    STRACE_FLAG_PVS_RESEARCH = 1 << 0, // 有子节点零宽窗口试探失败，用完整窗口重搜
+    STRACE_FLAG_LMR_RESEARCH = 1 << 1, // 有降低深度的子节点超出窗口，恢复完整深度重搜
+    STRACE_FLAG_NULL_FAILED  = 1 << 2, // 尝试了空着裁剪但没有剪掉
+    STRACE_FLAG_VERIFY       = 1 << 3  // 本记录是空着裁剪的验证搜索 (与所属节点同一层、同一走法)
+};
+
+struct SearchTraceRecord {
+    std::int32_t alpha;          // 进入节点时的窗口 (AI 视角)
+    std::int32_t beta;
+    std::int32_t score;          // 返回值
+    std::uint32_t subtree_nodes; // 以本节点为根的子树访问的节点数 (含本节点)
+    std::int16_t move;           // 到达本节点的走法 (r * 15 + c)，见 STRACE_NO_MOVE / STRACE_NULL_MOVE
+    std::uint8_t ply;            // 距根节点的层数
+    std::int8_t depth;           // 剩余深度
+    std::uint8_t reason;         // SearchTraceReason
+    std::uint8_t cut_index;      // BETA_CUTOFF 时引起剪枝的是第几个走法 (从 1 开始，最大 255)
+    std::uint8_t flags;          // SearchTraceFlag 的组合
+    std::uint8_t side;           // 轮到哪一方 (1:黑, 2:白)
+};
+static_assert(sizeof(SearchTraceRecord) == 24, "追踪记录的大小是文件格式的一部分");
+
+struct SearchTraceHeader {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t record_size;
+};
+
+// 带缓冲的追踪写入器: append 只复制到固定缓冲区，满了才整块写入文件
+class SearchTraceWriter {
+public:
+    SearchTraceWriter();
+    ~SearchTraceWriter();
+    SearchTraceWriter(const SearchTraceWriter&) = delete;
+    SearchTraceWriter& operator=(const SearchTraceWriter&) = delete;
+
+    // 创建 (覆盖) 追踪文件并写入文件头，失败返回 false
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return file != nullptr; }
+
+    void append(const SearchTraceRecord& record) {
+        buffer[buffered_count++] = record;
+        if (buffered_count == buffer.size()) flush();
+    }
+    void flush();
+    long long recordCount() const { return written_count + static_cast<long long>(buffered_count); }
+
+private:
+    std::FILE* file;
+    std::array<SearchTraceRecord, STRACE_BUFFER_RECORDS> buffer;
+    std::size_t buffered_count;
+    long long written_count;
+};
+
+// 读取整个追踪文件 (离线工具使用)，格式不符时返回 false
+bool readSearchTrace(const std::string& path, std::vector<SearchTraceRecord>& records);
+
+#endif // SEARCHTRACE_H
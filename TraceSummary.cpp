@@ -0,0 +1,245 @@
+// Copyright (c) 2025 wibyuan
+// Licensed under the MIT License (see LICENSE for details)
+//
+// 搜索树追踪的离线分析工具 (不依赖 SDL)，与基准测试程序一起通过 WIBYUAN_BUILD_BENCHMARK 构建。
+// 用法:
+//   WibyuanGomoku_trace_summary <追踪文件> [热点数]
+// 追踪文件由 AlphaBetaAI::setSearchTrace 生成。输出:
+//   1. 每次搜索的每一轮根节点搜索 (迭代深度、渴望窗口重搜、多主变例的各条线) 的窗口、结果与节点数
+//   2. 每次搜索中最耗节点的一轮: 节点最多的根走法，以及沿最大子树一路向下的热点路径
+//   3. 按层统计的剪枝情况: 首着剪枝率、靠后的走法才剪枝、PVS/LMR 重搜与空着失败
+//   4. 剪枝来得最晚、代价最大的节点 (走法排序失败的地方)
+#include "SearchTrace.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int TS_BOARD_N = 15;          // 走法编码 r * 15 + c
+const int TS_MAX_PLY = 64;
+const int TS_LATE_CUT_INDEX = 4;    // 第几个走法及以后才剪枝算作排序失败
+const int TS_HOT_PATH_STEPS = 16;
+
+const char* reasonName(std::uint8_t reason) {
+    static const char* names[] = {"开始", "中止", "终局", "叶子", "置换表截断", "空着剪枝",
+                                  "无走法", "剪枝", "精确", "低出窗口"};
+    return reason < sizeof(names) / sizeof(names[0]) ? names[reason] : "未知";
+}
+
+std::string moveName(const SearchTraceRecord& record) {
+    if (record.move == STRACE_NO_MOVE) return "根";
+    if (record.move == STRACE_NULL_MOVE) return "空着";
+    std::ostringstream out;
+    out << "(" << record.move / TS_BOARD_N << "," << record.move % TS_BOARD_N << ")";
+    if (record.flags & STRACE_FLAG_VERIFY) out << "[验证]";
+    return out.str();
+}
+
+std::string windowText(const SearchTraceRecord& record) {
+    auto bound = [](std::int32_t value) -> std::string {
+        if (value <= -1000000000) return "-inf";
+        if (value >= 1000000000) return "+inf";
+        return std::to_string(value);
+    };
+    return "[" + bound(record.alpha) + ", " + bound(record.beta) + "]";
+}
+
+// 由后序记录重建的树: parent 与按父节点分组的子节点列表
+struct TraceTree {
+    std::vector<int> parent;
+    std::vector<int> child_begin; // 子节点在 child_list 中的区间 [child_begin[i], child_begin[i + 1])
+    std::vector<int> child_list;
+};
+
+// 后序记录: 遇到第 ply 层的节点时，栈顶连续的 ply+1 层记录都是它的子节点。
+// 空着裁剪的验证搜索与所属节点同一层，作为该节点的子节点；验证搜索本身不收养空着子节点 (那属于所属节点)
+TraceTree buildTree(const std::vector<SearchTraceRecord>& records) {
+    TraceTree tree;
+    const int count = static_cast<int>(records.size());
+    tree.parent.assign(count, -1);
+    std::vector<int> pending;
+    for (int i = 0; i < count; ++i) {
+        const SearchTraceRecord& node = records[i];
+        if (node.reason == static_cast<std::uint8_t>(SearchTraceReason::SEARCH_BEGIN)) {
+            pending.clear();
+            continue;
+        }
+        const bool is_verify = (node.flags & STRACE_FLAG_VERIFY) != 0;
+        while (!pending.empty()) {
+            const SearchTraceRecord& top = records[pending.back()];
+            bool adopt = top.ply == node.ply + 1;
+            if (is_verify) adopt = adopt && top.move != STRACE_NULL_MOVE;
+            else adopt = adopt || (top.ply == node.ply && (top.flags & STRACE_FLAG_VERIFY) != 0);
+            if (!adopt) break;
+            tree.parent[pending.back()] = i;
+            pending.pop_back();
+        }
+        pending.push_back(i);
+    }
+
+    tree.child_begin.assign(count + 1, 0);
+    for (int i = 0; i < count; ++i) {
+        if (tree.parent[i] >= 0) ++tree.child_begin[tree.parent[i] + 1];
+    }
+    for (int i = 0; i < count; ++i) tree.child_begin[i + 1] += tree.child_begin[i];
+    tree.child_list.assign(tree.child_begin[count], 0);
+    std::vector<int> fill(tree.child_begin.begin(), tree.child_begin.end() - 1);
+    for (int i = 0; i < count; ++i) { // 按记录顺序 (即搜索顺序) 加入
+        if (tree.parent[i] >= 0) tree.child_list[fill[tree.parent[i]]++] = i;
+    }
+    return tree;
+}
+
+std::string pathText(const std::vector<SearchTraceRecord>& records, const TraceTree& tree, int index) {
+    std::vector<int> chain;
+    for (int i = index; i >= 0; i = tree.parent[i]) chain.push_back(i);
+    std::string text;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (!text.empty()) text += " ";
+        text += moveName(records[*it]);
+    }
+    return text;
+}
+
+void printHotSubtrees(const std::vector<SearchTraceRecord>& records, const TraceTree& tree, int root, int hot_count) {
+    const SearchTraceRecord& root_record = records[root];
+    std::vector<int> children(tree.child_list.begin() + tree.child_begin[root],
+                              tree.child_list.begin() + tree.child_begin[root + 1]);
+    std::stable_sort(children.begin(), children.end(), [&](int a, int b) {
+        return records[a].subtree_nodes > records[b].subtree_nodes;
+    });
+    std::cout << "  最耗节点的一轮: 深度 " << static_cast<int>(root_record.depth) << ", 窗口 " << windowText(root_record)
+              << ", 节点 " << root_record.subtree_nodes << std::endl;
+    std::cout << "  节点最多的根走法:" << std::endl;
+    for (int k = 0; k < hot_count && k < static_cast<int>(children.size()); ++k) {
+        const SearchTraceRecord& child = records[children[k]];
+        std::cout << "    " << std::setw(12) << moveName(child) << "  节点=" << std::setw(9) << child.subtree_nodes
+                  << " (" << std::fixed << std::setprecision(1)
+                  << 100.0 * child.subtree_nodes / std::max<std::uint32_t>(root_record.subtree_nodes, 1) << "%)"
+                  << "  结果=" << child.score << "  " << reasonName(child.reason) << std::endl;
+    }
+
+    std::cout << "  热点路径:";
+    int current = root;
+    for (int step = 0; step < TS_HOT_PATH_STEPS; ++step) {
+        int hottest = -1;
+        for (int k = tree.child_begin[current]; k < tree.child_begin[current + 1]; ++k) {
+            int child = tree.child_list[k];
+            if (hottest < 0 || records[child].subtree_nodes > records[hottest].subtree_nodes) hottest = child;
+        }
+        if (hottest < 0) break;
+        std::cout << " " << moveName(records[hottest]) << "=" << records[hottest].subtree_nodes;
+        current = hottest;
+    }
+    std::cout << std::endl;
+}
+
+struct PlyStats {
+    long long nodes = 0;
+    long long cutoffs = 0;
+    long long first_move_cutoffs = 0;
+    long long late_cutoffs = 0;
+    long long fail_lows = 0;
+    long long tt_cutoffs = 0;
+    long long pvs_researches = 0;
+    long long lmr_researches = 0;
+    long long null_failures = 0;
+};
+
+void printPlyStats(const std::vector<SearchTraceRecord>& records) {
+    std::array<PlyStats, TS_MAX_PLY> stats{};
+    int max_ply = 0;
+    for (const SearchTraceRecord& record : records) {
+        if (record.reason == static_cast<std::uint8_t>(SearchTraceReason::SEARCH_BEGIN) || record.ply >= TS_MAX_PLY) continue;
+        PlyStats& ply = stats[record.ply];
+        max_ply = std::max(max_ply, static_cast<int>(record.ply));
+        ++ply.nodes;
+        if (record.reason == static_cast<std::uint8_t>(SearchTraceReason::BETA_CUTOFF)) {
+            ++ply.cutoffs;
+            if (record.cut_index == 1) ++ply.first_move_cutoffs;
+            if (record.cut_index >= TS_LATE_CUT_INDEX) ++ply.late_cutoffs;
+        }
+        if (record.reason == static_cast<std::uint8_t>(SearchTraceReason::FAIL_LOW)) ++ply.fail_lows;
+        if (record.reason == static_cast<std::uint8_t>(SearchTraceReason::TT_CUTOFF)) ++ply.tt_cutoffs;
+        if (record.flags & STRACE_FLAG_PVS_RESEARCH) ++ply.pvs_researches;
+        if (record.flags & STRACE_FLAG_LMR_RESEARCH) ++ply.lmr_researches;
+        if (record.flags & STRACE_FLAG_NULL_FAILED) ++ply.null_failures;
+    }
+    std::cout << "按层统计 (第 " << TS_LATE_CUT_INDEX << " 个及以后的走法才剪枝记为靠后):" << std::endl;
+    std::cout << "  层      节点      剪枝  首着剪枝率  靠后剪枝  低出窗口  置换表截断  PVS重搜  LMR重搜  空着失败" << std::endl;
+    for (int p = 0; p <= max_ply; ++p) {
+        const PlyStats& ply = stats[p];
+        if (ply.nodes == 0) continue;
+        std::cout << "  " << std::setw(2) << p << "  " << std::setw(8) << ply.nodes << "  " << std::setw(8) << ply.cutoffs
+                  << "  " << std::setw(9) << std::fixed << std::setprecision(1)
+                  << (ply.cutoffs > 0 ? 100.0 * ply.first_move_cutoffs / ply.cutoffs : 0.0) << "%"
+                  << "  " << std::setw(8) << ply.late_cutoffs << "  " << std::setw(8) << ply.fail_lows
+                  << "  " << std::setw(10) << ply.tt_cutoffs << "  " << std::setw(7) << ply.pvs_researches
+                  << "  " << std::setw(7) << ply.lmr_researches << "  " << std::setw(8) << ply.null_failures << std::endl;
+    }
+}
+
+// 剪枝来得晚的节点: 前面的走法都白搜了，子树越大代价越高
+void printOrderingFailures(const std::vector<SearchTraceRecord>& records, const TraceTree& tree, int hot_count) {
+    std::vector<int> late;
+    for (int i = 0; i < static_cast<int>(records.size()); ++i) {
+        if (records[i].reason == static_cast<std::uint8_t>(SearchTraceReason::BETA_CUTOFF) && records[i].cut_index > 1) late.push_back(i);
+    }
+    std::stable_sort(late.begin(), late.end(), [&](int a, int b) { return records[a].subtree_nodes > records[b].subtree_nodes; });
+    std::cout << "代价最大的晚剪枝节点:" << std::endl;
+    for (int k = 0; k < hot_count && k < static_cast<int>(late.size()); ++k) {
+        const SearchTraceRecord& record = records[late[k]];
+        std::cout << "  节点=" << std::setw(8) << record.subtree_nodes << "  第 " << static_cast<int>(record.cut_index)
+                  << " 个走法剪枝  深度=" << static_cast<int>(record.depth) << "  窗口=" << windowText(record)
+                  << "  路径: " << pathText(records, tree, late[k]) << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <追踪文件> [热点数]" << std::endl;
+        return 1;
+    }
+    const int hot_count = argc > 2 ? std::max(1, std::atoi(argv[2])) : 8;
+    std::vector<SearchTraceRecord> records;
+    if (!readSearchTrace(argv[1], records)) {
+        std::cerr << "无法读取追踪文件 (不存在或格式不符): " << argv[1] << std::endl;
+        return 1;
+    }
+    const TraceTree tree = buildTree(records);
+    std::cout << "追踪文件 " << argv[1] << ": " << records.size() << " 条记录" << std::endl;
+
+    // 按 SEARCH_BEGIN 分段，逐次搜索输出根节点的每一轮
+    int search_number = 0;
+    int heaviest_root = -1;
+    auto finishSearch = [&]() {
+        if (heaviest_root >= 0) printHotSubtrees(records, tree, heaviest_root, hot_count);
+        heaviest_root = -1;
+    };
+    for (int i = 0; i < static_cast<int>(records.size()); ++i) {
+        const SearchTraceRecord& record = records[i];
+        if (record.reason == static_cast<std::uint8_t>(SearchTraceReason::SEARCH_BEGIN)) {
+            finishSearch();
+            std::cout << "搜索 #" << ++search_number << ": 棋子 " << record.subtree_nodes << " 个, 执"
+                      << (record.side == 1 ? "黑" : "白") << ", 目标深度 " << static_cast<int>(record.depth) << std::endl;
+            continue;
+        }
+        if (record.ply != 0 || (record.flags & STRACE_FLAG_VERIFY)) continue;
+        std::cout << "  深度 " << std::setw(2) << static_cast<int>(record.depth) << "  窗口=" << windowText(record)
+                  << "  结果=" << record.score << "  节点=" << record.subtree_nodes << "  " << reasonName(record.reason) << std::endl;
+        if (heaviest_root < 0 || record.subtree_nodes > records[heaviest_root].subtree_nodes) heaviest_root = i;
+    }
+    finishSearch();
+
+    printPlyStats(records);
+    printOrderingFailures(records, tree, hot_count);
+    return 0;
+}
@@ -0,0 +1,321 @@
+// Copyright (c) 2025 wibyuan
+// Licensed under the MIT License (see LICENSE for details)
+#include "TranspositionTable.h"
+#include <iostream>  // 用于调试输出
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 置换表文件的布局: 64 字节的文件头，其后紧跟桶数组 (映射区域按页对齐，桶仍按缓存行对齐)
+// 文件中的槽直接被多个进程映射，只有原子操作本身无锁时跨进程共享才成立
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "跨进程共享置换表要求 64 位原子操作无锁");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "跨进程共享置换表要求 32 位原子操作无锁");
+
+const std::uint64_t TT_FILE_MAGIC = 0x31305454594257ULL; // "WBYTT01"
+const std::uint32_t TT_FILE_VERSION = 1;
+const std::size_t TT_FILE_HEADER_SIZE = 64;
+
+struct TTFileInfo {
+    std::uint64_t magic;        // 最后写入，其余字段写好之前其他进程不会认为文件有效
+    std::uint32_t version;
+    std::uint32_t bucket_bytes; // sizeof(TTBucket)，防止不同编译结果的布局不一致
+    std::uint64_t bucket_num;
+    std::uint64_t format_tag;
+};
+
+struct TTFileHeader {
+    TTFileInfo info;
+    std::atomic<std::uint32_t> generation; // 各进程共用的代数，newSearch 时更新
+};
+static_assert(sizeof(TTFileHeader) <= TT_FILE_HEADER_SIZE, "文件头超出预留的 64 字节");
+static_assert(TT_FILE_HEADER_SIZE % alignof(TTBucket) == 0, "桶数组必须保持缓存行对齐");
+
+bool fileInfoValid(const TTFileInfo& info, std::uint64_t format_tag, std::uint64_t file_size) {
+    if (info.magic != TT_FILE_MAGIC || info.version != TT_FILE_VERSION ||
+        info.bucket_bytes != sizeof(TTBucket) || info.format_tag != format_tag) return false;
+    if (info.bucket_num == 0 || (info.bucket_num & (info.bucket_num - 1)) != 0) return false;
+    return file_size == TT_FILE_HEADER_SIZE + info.bucket_num * sizeof(TTBucket);
+}
+
+} // namespace
+
+TranspositionTable::TranspositionTable(std::size_t size_mb) :
+    buckets(nullptr),
+    bucket_num(0),
+    bucket_mask(0),
+    current_generation(0),
+    mapped_view(nullptr),
+    mapped_size(0),
+#ifdef _WIN32
+    file_handle(nullptr),
+    mapping_handle(nullptr)
+#else
+    file_descriptor(-1)
+#endif
+{
+    resize(size_mb);
+}
+
+TranspositionTable::~TranspositionTable() {
+    closeFile();
+}
+
+std::size_t TranspositionTable::bucketCountFor(std::size_t size_mb) {
+    if (size_mb == 0) size_mb = 1;
+    std::size_t max_buckets = size_mb * 1024 * 1024 / sizeof(TTBucket);
+    std::size_t new_bucket_num = 1;
+    while (new_bucket_num * 2 <= max_buckets) new_bucket_num *= 2; // 向下取整到 2 的幂，便于用掩码取下标
+    return new_bucket_num;
+}
+
+void TranspositionTable::resize(std::size_t size_mb) {
+    closeFile();
+    std::size_t new_bucket_num = bucketCountFor(size_mb);
+    owned_buckets.reset(new TTBucket[new_bucket_num]);
+    buckets = owned_buckets.get();
+    bucket_num = new_bucket_num;
+    bucket_mask = new_bucket_num - 1;
+    clear();
+    std::cout << "[调试] 置换表已分配: " << bucket_num << " 个桶, "
+              << sizeInBytes() / 1024 << " KB。" << std::endl;
+}
+
+bool TranspositionTable::openFile(const std::string& path, std::size_t size_mb, std::uint64_t format_tag) {
+    const std::size_t requested_bucket_num = bucketCountFor(size_mb);
+    TTFileInfo info = {};
+    std::uint64_t file_size = 0;
+    void* view = nullptr;
+    std::size_t view_size = 0;
+
+    // 检查文件头并在需要时重建的过程持有文件锁，避免两个进程同时初始化同一文件
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "[错误] 无法打开置换表文件: " << path << std::endl;
+        return false;
+    }
+    OVERLAPPED lock_range = {};
+    lock_range.OffsetHigh = 0x40000000; // 锁住远在文件末尾之外的一个字节，不影响读取与映射
+    if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &lock_range)) { // 不加锁就共享文件可能与其他进程同时重建
+        CloseHandle(file);
+        std::cerr << "[错误] 无法锁定置换表文件: " << path << std::endl;
+        return false;
+    }
+    LARGE_INTEGER size_info;
+    if (GetFileSizeEx(file, &size_info)) file_size = static_cast<std::uint64_t>(size_info.QuadPart);
+    DWORD bytes_read = 0;
+    if (file_size >= sizeof(info)) ReadFile(file, &info, sizeof(info), &bytes_read, nullptr);
+#else
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "[错误] 无法打开置换表文件: " << path << std::endl;
+        return false;
+    }
+    if (flock(fd, LOCK_EX) != 0) { // 不加锁就共享文件可能与其他进程同时重建
+        ::close(fd);
+        std::cerr << "[错误] 无法锁定置换表文件: " << path << std::endl;
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0) file_size = static_cast<std::uint64_t>(file_stat.st_size);
+    if (file_size >= sizeof(info) && pread(fd, &info, sizeof(info), 0) != static_cast<ssize_t>(sizeof(info))) {
+        info = TTFileInfo{};
+    }
+#endif
+
+    // 已有的有效文件沿用其桶数 (与其他进程一致)，否则按请求的大小重建
+    const bool reuse = fileInfoValid(info, format_tag, file_size);
+    const std::size_t new_bucket_num = reuse ? static_cast<std::size_t>(info.bucket_num) : requested_bucket_num;
+    view_size = TT_FILE_HEADER_SIZE + new_bucket_num * sizeof(TTBucket);
+
+#ifdef _WIN32
+    // CreateFileMapping 只会把文件扩展到映射大小，重建时先把文件截断到该大小，
+    // 否则比预期大的旧文件永远通不过 fileInfoValid 的大小检查
+    HANDLE mapping = nullptr;
+    LARGE_INTEGER new_size;
+    new_size.QuadPart = static_cast<LONGLONG>(view_size);
+    if (reuse || (SetFilePointerEx(file, new_size, nullptr, FILE_BEGIN) && SetEndOfFile(file))) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+                                     static_cast<DWORD>(static_cast<std::uint64_t>(view_size) >> 32),
+                                     static_cast<DWORD>(view_size & 0xFFFFFFFFu), nullptr);
+    }
+    if (mapping != nullptr) view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, view_size);
+    if (view == nullptr) {
+        if (mapping != nullptr) CloseHandle(mapping);
+        UnlockFileEx(file, 0, 1, 0, &lock_range);
+        CloseHandle(file);
+        std::cerr << "[错误] 无法映射置换表文件: " << path << std::endl;
+        return false;
+    }
+#else
+    if ((!reuse && ftruncate(fd, static_cast<off_t>(view_size)) != 0) ||
+        (view = mmap(nullptr, view_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        flock(fd, LOCK_UN);
+        ::close(fd);
+        std::cerr << "[错误] 无法映射置换表文件: " << path << std::endl;
+        return false;
+    }
+#endif
+
+    closeFile();
+    owned_buckets.reset();
+    mapped_view = view;
+    mapped_size = view_size;
+#ifdef _WIN32
+    file_handle = file;
+    mapping_handle = mapping;
+#else
+    file_descriptor = fd;
+#endif
+    TTFileHeader* header = static_cast<TTFileHeader*>(mapped_view);
+    buckets = reinterpret_cast<TTBucket*>(static_cast<char*>(mapped_view) + TT_FILE_HEADER_SIZE);
+    bucket_num = new_bucket_num;
+    bucket_mask = new_bucket_num - 1;
+
+    if (reuse) {
+        current_generation.store(static_cast<std::uint8_t>(header->generation.load(std::memory_order_relaxed) & 0x3F),
+                                 std::memory_order_relaxed);
+    } else {
+        header->info.magic = 0;
+        clear();
+        header->info.version = TT_FILE_VERSION;
+        header->info.bucket_bytes = static_cast<std::uint32_t>(sizeof(TTBucket));
+        header->info.bucket_num = new_bucket_num;
+        header->info.format_tag = format_tag;
+        std::atomic_thread_fence(std::memory_order_release);
+        header->info.magic = TT_FILE_MAGIC;
+    }
+
+#ifdef _WIN32
+    UnlockFileEx(file, 0, 1, 0, &lock_range);
+#else
+    flock(fd, LOCK_UN);
+#endif
+    std::cout << "[调试] 置换表已映射到文件 " << path << ": " << bucket_num << " 个桶, "
+              << sizeInBytes() / 1024 << " KB, " << (reuse ? "沿用已有内容" : "新建") << "。" << std::endl;
+    return true;
+}
+
+void TranspositionTable::closeFile() {
+    if (mapped_view == nullptr) return;
+#ifdef _WIN32
+    UnmapViewOfFile(mapped_view);
+    CloseHandle(static_cast<HANDLE>(mapping_handle));
+    CloseHandle(static_cast<HANDLE>(file_handle));
+    file_handle = nullptr;
+    mapping_handle = nullptr;
+#else
+    munmap(mapped_view, mapped_size);
+    ::close(file_descriptor);
+    file_descriptor = -1;
+#endif
+    mapped_view = nullptr;
+    mapped_size = 0;
+    buckets = nullptr;
+    bucket_num = 0;
+    bucket_mask = 0;
+}
+
+void TranspositionTable::clear() {
+    for (std::size_t i = 0; i < bucket_num; ++i) {
+        for (TTSlot& slot : buckets[i].slots) {
+            slot.check.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    current_generation.store(0, std::memory_order_relaxed);
+    if (mapped_view != nullptr) static_cast<TTFileHeader*>(mapped_view)->generation.store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::newSearch() {
+    std::uint8_t gen = current_generation.load(std::memory_order_relaxed);
+    if (mapped_view != nullptr) { // 跟随其他进程推进的代数，免得本进程的新条目被当成旧条目
+        gen = static_cast<std::uint8_t>(static_cast<TTFileHeader*>(mapped_view)->generation.load(std::memory_order_relaxed));
+    }
+    gen = (gen + 1) & 0x3F; // 代数只有 6 位
+    current_generation.store(gen, std::memory_order_relaxed);
+    if (mapped_view != nullptr) static_cast<TTFileHeader*>(mapped_view)->generation.store(gen, std::memory_order_relaxed);
+}
+
+// data 的布局: [0,32) 分数, [32,48) 走法, [48,56) 深度, [56,64) 边界与代数
+std::uint64_t TranspositionTable::packData(int score, int best_move, int depth, std::uint8_t bound_gen) {
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(score)) |
+           (static_cast<std::uint64_t>(static_cast<std::uint16_t>(best_move)) << 32) |
+           (static_cast<std::uint64_t>(static_cast<std::uint8_t>(depth)) << 48) |
+           (static_cast<std::uint64_t>(bound_gen) << 56);
+}
+
+TTEntry TranspositionTable::unpackData(std::uint64_t key, std::uint64_t data) {
+    TTEntry entry;
+    entry.key = key;
+    entry.score = static_cast<std::int32_t>(static_cast<std::uint32_t>(data));
+    entry.best_move = static_cast<std::int16_t>(static_cast<std::uint16_t>(data >> 32));
+    entry.depth = static_cast<std::uint8_t>(data >> 48);
+    entry.bound_gen = static_cast<std::uint8_t>(data >> 56);
+    return entry;
+}
+
+bool TranspositionTable::probe(std::uint64_t key, TTEntry& out) const {
+    const TTBucket& bucket = buckets[key & bucket_mask];
+    for (const TTSlot& slot : bucket.slots) {
+        std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+        std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && (data >> 56 & 0x3) != static_cast<std::uint64_t>(TTBound::NONE)) {
+            out = unpackData(key, data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(std::uint64_t key, int depth, TTBound bound, int score, int best_move) {
+    TTBucket& bucket = buckets[key & bucket_mask];
+    const int generation = current_generation.load(std::memory_order_relaxed);
+
+    // 选择替换目标: 同一局面 > 空槽 > 旧代数且深度最浅的条目
+    TTSlot* target = &bucket.slots[0];
+    TTEntry target_entry = unpackData(0, 0);
+    int worst_value = 1 << 30;
+    for (TTSlot& slot : bucket.slots) {
+        std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+        TTEntry entry = unpackData(slot.check.load(std::memory_order_relaxed) ^ data, data);
+        if (entry.key == key || entry.bound() == TTBound::NONE) {
+            target = &slot;
+            target_entry = entry;
+            break;
+        }
+        int age = (generation - entry.generation()) & 0x3F;
+        int value = entry.depth - 8 * age; // 越小越应该被替换
+        if (value < worst_value) {
+            worst_value = value;
+            target = &slot;
+            target_entry = entry;
+        }
+    }
+
+    // 同一局面时，若新结果没有提供走法，则保留旧的最佳走法
+    if (target_entry.key == key && target_entry.bound() != TTBound::NONE && best_move < 0) {
+        best_move = target_entry.best_move;
+    }
+
+    std::uint8_t bound_gen = static_cast<std::uint8_t>((generation << 2) | static_cast<std::uint8_t>(bound));
+    std::uint64_t data = packData(score, best_move, depth < 0 ? 0 : depth, bound_gen);
+    target->data.store(data, std::memory_order_relaxed);
+    target->check.store(key ^ data, std::memory_order_relaxed);
+}
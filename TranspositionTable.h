@@ -0,0 +1,102 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+// Copyright (c) 2025 wibyuan
+// Licensed under the MIT License (see LICENSE for details)
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <string>
+
+// 置换表中记录的分数边界类型
+enum class TTBound : std::uint8_t {
+    NONE  = 0, // 空槽
+    EXACT = 1, // 精确值
+    LOWER = 2, // 下界 (发生了 beta 剪枝)
+    UPPER = 3  // 上界 (所有走法都没有超过 alpha)
+};
+
+// 置换表条目 (解码后的形式，由 probe 返回)
+struct TTEntry {
+    std::uint64_t key;        // 局面的 Zobrist 哈希值
+    std::int32_t score;       // 搜索得到的分数 (AI 视角)
+    std::int16_t best_move;   // 最佳走法 (r * N + c)，-1 表示无
+    std::uint8_t depth;       // 该分数对应的剩余搜索深度
+    std::uint8_t bound_gen;   // 低 2 位: TTBound，高 6 位: 代数 (用于淘汰旧条目)
+
+    TTBound bound() const { return static_cast<TTBound>(bound_gen & 0x3); }
+    int generation() const { return bound_gen >> 2; }
+};
+
+const int TT_BUCKET_SIZE = 4; // 每个桶 4 个槽，正好 64 字节 (一条缓存行)
+
+// 表中实际存储的槽，16 字节
+// 多个搜索线程无锁地共享同一张表: data 打包了分数/走法/深度/边界，
+// check 存的是 key ^ data。读到的两个字不是同一次写入时校验会失败，
+// 相当于未命中，因此不需要加锁。
+struct TTSlot {
+    std::atomic<std::uint64_t> check;
+    std::atomic<std::uint64_t> data;
+};
+
+// 按缓存行对齐的桶，一次探测只会访问一条缓存行
+struct alignas(64) TTBucket {
+    TTSlot slots[TT_BUCKET_SIZE];
+};
+
+class TranspositionTable {
+public:
+    // size_mb: 置换表占用的内存大小 (MB)，实际桶数会向下取整到 2 的幂
+    explicit TranspositionTable(std::size_t size_mb = 16);
+    ~TranspositionTable();
+
+    // 重新设置大小 (会清空所有内容)。若此前映射了文件，则断开映射改回内存中的表，文件内容保留
+    void resize(std::size_t size_mb);
+
+    // 改用文件映射的表: 同一台机器上的多个进程可同时映射同一文件，槽的读写与内存中的表一样无锁，
+    // 进程退出后内容保留在文件中。文件已存在且头部 (格式版本、桶数、format_tag) 有效时沿用其大小与内容，
+    // 否则按 size_mb 重新建立。format_tag 由调用方给出，哈希或分数的含义改变时应随之改变，旧文件随即失效。
+    // 失败时返回 false，继续使用原来的表
+    bool openFile(const std::string& path, std::size_t size_mb, std::uint64_t format_tag);
+    bool isFileBacked() const { return mapped_view != nullptr; }
+
+    // 清空所有条目
+    void clear();
+
+    // 开始新一轮搜索 (每次 getMove 调用一次)，旧代数的条目会被优先替换
+    void newSearch();
+
+    // 查找局面，命中时将条目复制到 out 并返回 true (可被多个线程同时调用)
+    bool probe(std::uint64_t key, TTEntry& out) const;
+
+    // 写入局面 (可被多个线程同时调用)
+    void store(std::uint64_t key, int depth, TTBound bound, int score, int best_move);
+
+    std::size_t bucketCount() const { return bucket_num; }
+    std::size_t sizeInBytes() const { return bucket_num * sizeof(TTBucket); }
+
+private:
+    static std::uint64_t packData(int score, int best_move, int depth, std::uint8_t bound_gen);
+    static TTEntry unpackData(std::uint64_t key, std::uint64_t data);
+    static std::size_t bucketCountFor(std::size_t size_mb);
+    void closeFile();
+
+    TTBucket* buckets;                          // 指向 owned_buckets 或映射文件中的桶数组
+    std::unique_ptr<TTBucket[]> owned_buckets;  // 内存中的表 (映射文件时为空)
+    std::size_t bucket_num;
+    std::size_t bucket_mask;
+    std::atomic<std::uint8_t> current_generation;
+
+    // 文件映射 (openFile 成功后有效)
+    void* mapped_view;        // 映射区域起点，即文件头
+    std::size_t mapped_size;
+#ifdef _WIN32
+    void* file_handle;        // HANDLE，避免在头文件中包含 windows.h
+    void* mapping_handle;
+#else
+    int file_descriptor;
+#endif
+};
+
+#endif // TRANSPOSITIONTABLE_H